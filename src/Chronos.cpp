@@ -1,11 +1,13 @@
 #include <csignal>
 #include <cstdlib>
 #include "fmt/color.h"
+#include "chronos/Cache.hpp"
 #include "chronos/Coordinator.hpp"
 #include "chronos/Dispatcher.hpp"
 #include "chronos/Filesystem.hpp"
 #include "chronos/Logging.hpp"
 #include "chronos/Parser.hpp"
+#include "chronos/Reactor.hpp"
 #include "chronos/Schedule.hpp"
 #include "chronos/System.hpp"
 #include "chronos/Task.hpp"
@@ -31,20 +33,30 @@ namespace chronos::detail
         if (argc != CORRECT_ARGC)
             throw error::WrongNumberOfArguments(--argc);
     }
+
+    // "chronos compile <file>" compiles the schedule instead of running it
+    bool is_compile_command(int argc, char **argv)
+    {
+        constexpr auto COMPILE_ARGC { 3 };
+        constexpr std::string_view COMPILE_COMMAND { "compile" };
+        return argc == COMPILE_ARGC && argv[1] == COMPILE_COMMAND;
+    }
 }
 
 namespace chronos
 {
-    using clock_t_ = boost::posix_time::second_clock;
+    // Due times are checked to the microsecond, not truncated to a second
+    using clock_t_ = boost::posix_time::microsec_clock;
     using schedule_t = ScheduleLoggingProxy<Schedule<Task, clock_t_> >;
-    using system_call_t = SystemCallLoggingProxy<SystemCall>;
+    using execution_t = AsyncSystemCallLoggingProxy<ReactorCall>;
     using dispatcher_t = DispatcherLoggingProxy<
-            Dispatcher<schedule_t, system_call_t> >;
+            AsyncDispatcher<schedule_t, execution_t> >;
     using task_buidler_t = TaskBuilder<clock_t_>;
     using parser_t = Parser<task_buidler_t>;
     using logging_parser_t = ParserLoggingProxy<parser_t>;
     using coordinator_t = CoordinatorThread<dispatcher_t, Timer>;
     using file_lock_t = FileLock<Timer>;
+    using task_reader_t = filesystem::reader::TaskReader<logging_parser_t>;
 
     void print_error_message(const std::string &message)
     {
@@ -58,11 +70,37 @@ namespace chronos
 
 namespace chronos::program
 {
+    // A compiled schedule of the very same contents spares parsing them
+    std::vector<Task> parse_schedule(const std_filesystem::path &file,
+                                     std::string_view contents)
+    {
+        if (auto tasks { cache::load_compiled<clock_t_>(file, contents) }) {
+            logging::parser::log_compiled_schedule_loaded(tasks->size());
+            return std::move(*tasks);
+        }
+        return logging_parser_t().parse(contents);
+    }
+
+    std::vector<Task> read_schedule(const std_filesystem::path &path,
+                                    task_reader_t &reader)
+    {
+        if (std_filesystem::is_directory(path))
+            return reader.read(path);
+        filesystem::detail::check_if_file_exist(path);
+        const filesystem::detail::FileContents file(path);
+        return parse_schedule(path, file.contents());
+    }
+
     std::shared_ptr<dispatcher_t>
-    setup_dispatcher(const std_filesystem::path &file)
+    setup_dispatcher(const std_filesystem::path &file, task_reader_t &reader)
     {
-        auto schedule { read_schedule_file<parser_t, schedule_t>(file) };
-        return std::make_shared<dispatcher_t>(schedule);
+        constexpr std::size_t EXECUTION_SLOTS { 64 };
+        auto schedule { std::make_shared<schedule_t>() };
+        for (const auto &task : read_schedule(file, reader))
+            schedule->add(task);
+        auto dispatcher { std::make_shared<dispatcher_t>(schedule) };
+        dispatcher->setCapacity(EXECUTION_SLOTS);
+        return dispatcher;
     }
 
     std::unique_ptr<file_lock_t>
@@ -71,28 +109,43 @@ namespace chronos::program
         return std::make_unique<file_lock_t>(file);
     }
 
+    std::unique_ptr<coordinator_t>
+    setup_coordinator(std::shared_ptr<dispatcher_t> dispatcher)
+    {
+        return std::make_unique<coordinator_t>(dispatcher);
+    }
+
+    /*
+     * The coordinator keeps dispatching on its own thread for the whole
+     * run. Changes of the schedule file are waited for, parsed and
+     * reconciled with the live schedule on the program thread, so due
+     * tasks are not held up by a reload.
+     */
     class Program
     {
     private:
         struct Context
         {
-            explicit Context(const std_filesystem::path &path)
-                : dispatcher(setup_dispatcher(path)),
-                lock(setup_file_lock(path)) { }
+            Context(const std_filesystem::path &path, task_reader_t &reader)
+                : dispatcher(setup_dispatcher(path, reader)),
+                lock(setup_file_lock(path)),
+                coordinator(setup_coordinator(dispatcher)) { }
 
             std::shared_ptr<dispatcher_t> dispatcher;
             std::unique_ptr<file_lock_t> lock;
+            std::unique_ptr<coordinator_t> coordinator;
         };
 
     public:
         explicit Program(const std_filesystem::path &path)
             : source_file(path),
-            context(path) { }
+            context(path, reader) { }
 
         void run()
         {
             while (!stopped)
                 loop();
+            context.coordinator->terminate();
         }
 
         void stop()
@@ -104,32 +157,40 @@ namespace chronos::program
     private:
         void loop()
         {
-            coordinate();
+            waitForChange();
             if (!stopped)
                 reload();
         }
 
-        void coordinate() const
+        void waitForChange() const
         {
             using seconds_t = boost::posix_time::seconds;
+            // File is polled that often only when inotify is unavailable
             constexpr int FILE_CHECK_INTERVAL { 60 };
-            coordinator_t coordinator(context.dispatcher);
             context.lock->waitUntilChange(seconds_t(FILE_CHECK_INTERVAL));
-            coordinator.terminate();
         }
 
         void reload()
         {
             try {
-                auto new_schedule {
-                    read_schedule_file<logging_parser_t , schedule_t>(
-                            source_file) };
-                context.dispatcher->reload(new_schedule);
+                context.dispatcher->reload(readChange());
             } catch (...) { }
         }
 
+        // Parses the very contents the change was detected in. Tasks own
+        // their text, so the contents are freed before they are reconciled.
+        std::vector<Task> readChange()
+        {
+            const auto change { context.lock->takeChange() };
+            return change
+                ? parse_schedule(source_file, change->contents())
+                : read_schedule(source_file, reader);
+        }
+
         std::atomic<bool> stopped { false };
         std_filesystem::path source_file;
+        // Keeps the fragments of a schedule directory parsed across reloads
+        task_reader_t reader;
         Context context;
     };
 
@@ -178,6 +239,13 @@ namespace chronos
         return std::make_unique<MainThread>(path);
     }
 
+    void compile(const std_filesystem::path &path)
+    {
+        const auto count { cache::compile_file<task_buidler_t>(path) };
+        fmt::print("Compiled {} tasks into {}\n", count,
+                   cache::compiled_path(path).string());
+    }
+
     void wait_for_interrupt()
     {
         using seconds_t = boost::posix_time::seconds;
@@ -197,6 +265,16 @@ namespace chronos::signals
 
 int main(int argc, char **argv)
 {
+    if (chronos::detail::is_compile_command(argc, argv)) {
+        try {
+            chronos::compile(argv[2]);
+        } catch (const std::exception &error) {
+            chronos::print_error_message(error.what());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     void (*interrupt_handler) (int);
     interrupt_handler = signal(SIGINT, chronos::signals::interrupt);
 
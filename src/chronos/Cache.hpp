@@ -0,0 +1,279 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "fmt/core.h"
+#include "chronos/Filesystem.hpp"
+#include "chronos/Parser.hpp"
+#include "chronos/Task.hpp"
+
+
+namespace chronos::cache::error
+{
+    class CompilationNotWritten : public std::runtime_error
+    {
+    public:
+        explicit CompilationNotWritten(const std::string &path)
+            : std::runtime_error(fmt::format(
+                    "Compiled schedule could not be written : {}", path)) { }
+    };
+}
+
+namespace chronos::cache::format
+{
+    constexpr std::array<char, 8> MAGIC { 'C', 'H', 'R', 'O',
+                                          'N', 'O', 'S', 'C' };
+    // Bumped whenever the layout or the meaning of a field changes
+    constexpr std::uint32_t VERSION { 3 };
+
+    using task::Alignment;
+
+    /*
+     * A compiled schedule is this header, the tasks in schedule order and
+     * then the text of their commands and group names, all of it in host
+     * byte order. The task size guards against a layout of another build.
+     */
+    struct Header
+    {
+        std::array<char, 8> magic { MAGIC };
+        std::uint32_t version { VERSION };
+        std::uint32_t task_size { 0 };
+        std::uint64_t source_size { 0 };
+        std::uint64_t source_hash { 0 };
+        std::uint64_t tasks_count { 0 };
+        std::uint64_t text_size { 0 };
+    };
+
+    struct CompiledTask
+    {
+        TaskRecord record;
+        std::uint32_t command_offset { 0 };
+        std::uint32_t command_size { 0 };
+        std::uint32_t group_offset { 0 };
+        std::uint32_t group_size { 0 };
+        Alignment alignment { Alignment::NEXT_MINUTE };
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header>);
+    static_assert(std::is_trivially_copyable_v<CompiledTask>);
+}
+
+namespace chronos::cache::detail
+{
+    using format::Alignment;
+
+    constexpr std::string_view COMPILED_EXTENSION { ".compiled" };
+
+    template <typename ValueT>
+    ValueT read_at(std::string_view image, std::size_t offset)
+    {
+        ValueT value;
+        std::memcpy(&value, image.data() + offset, sizeof(ValueT));
+        return value;
+    }
+
+    /*
+     * Whether the text of a compiled task lies within the text of the
+     * image and its fields hold values they can take: a cron expression
+     * within its ranges, or an interval which moves the task on.
+     */
+    bool is_valid(const format::CompiledTask &compiled,
+                  std::size_t text_size)
+    {
+        const auto &record { compiled.record };
+        const auto has_schedule { compiled.alignment == Alignment::CRON
+            ? cron::is_set(record.cron) && cron::detail::has_day(record.cron)
+            : record.interval_count > 0 };
+        return compiled.command_offset
+                   + std::uint64_t(compiled.command_size) <= text_size
+            && compiled.group_offset
+                   + std::uint64_t(compiled.group_size) <= text_size
+            && record.interval_unit < std::variant_size_v<duration_t>
+            && record.priority <= task::Priority::CRITICAL
+            && compiled.alignment <= Alignment::CRON
+            && cron::is_valid(record.cron)
+            && has_schedule;
+    }
+
+    template <typename ValueT>
+    void append(std::string &image, const ValueT &value)
+    {
+        image.append(reinterpret_cast<const char*>(&value), sizeof(ValueT));
+    }
+}
+
+namespace chronos::cache
+{
+    // Compiled schedule of a source file is kept right next to it
+    std_filesystem::path compiled_path(const std_filesystem::path &source)
+    {
+        auto path { source };
+        path += std::string(detail::COMPILED_EXTENSION);
+        return path;
+    }
+
+    std::uint64_t source_hash(std::string_view source)
+    {
+        return task::detail::stable_hash(source);
+    }
+
+    /*
+     * Parses and converts the source once and lays the tasks out flat.
+     * Times are not stored, they are aligned again when loaded.
+     */
+    template <typename TaskBuilderT>
+    std::string compile(std::string_view source)
+    {
+        const auto chunks { parser::parse_chunks(source) };
+        std::vector<format::CompiledTask> tasks;
+        std::string text;
+        std::map<std::string, std::uint32_t, std::less<>> groups;
+        parser::Converter<TaskBuilderT> converter;
+        for (const auto &chunk : chunks)
+            for (const auto &entry : chunk.entries) {
+                const auto task { converter.convert(entry) };
+                // Padding is written too, zeroed for the same bytes each time
+                auto &compiled { tasks.emplace_back() };
+                std::memset(static_cast<void*>(&compiled), 0,
+                            sizeof(compiled));
+                fill_record(task, compiled.record);
+                compiled.alignment = task.alignment;
+                compiled.command_offset = text.size();
+                compiled.command_size = task.command.size();
+                text += task.command;
+                auto group { groups.find(task.group.name) };
+                if (group == groups.end()) {
+                    group = groups.emplace(task.group.name, text.size()).first;
+                    text += task.group.name;
+                }
+                compiled.group_offset = group->second;
+                compiled.group_size = task.group.name.size();
+            }
+
+        format::Header header;
+        header.task_size = sizeof(format::CompiledTask);
+        header.source_size = source.size();
+        header.source_hash = source_hash(source);
+        header.tasks_count = tasks.size();
+        header.text_size = text.size();
+
+        std::string image;
+        image.reserve(sizeof(header)
+                      + tasks.size() * sizeof(format::CompiledTask)
+                      + text.size());
+        detail::append(image, header);
+        for (const auto &task : tasks)
+            detail::append(image, task);
+        image += text;
+        return image;
+    }
+
+    /*
+     * Tasks of a compiled schedule, or nothing when it was compiled from
+     * another source, by another version or is damaged. Tasks sharing an
+     * alignment and a splay offset share their first time, which is
+     * looked up once, except cron tasks whose expressions tell theirs.
+     */
+    template <typename ClockT>
+    std::optional<std::vector<Task>> load(std::string_view image,
+                                          std::string_view source)
+    {
+        using format::CompiledTask;
+        if (image.size() < sizeof(format::Header))
+            return std::nullopt;
+        const auto header { detail::read_at<format::Header>(image, 0) };
+        const auto tasks_size { header.tasks_count * sizeof(CompiledTask) };
+        if (header.magic != format::MAGIC
+                || header.version != format::VERSION
+                || header.task_size != sizeof(CompiledTask)
+                || header.source_size != source.size()
+                || header.tasks_count > image.size() / sizeof(CompiledTask)
+                || image.size() != sizeof(format::Header) + tasks_size
+                                   + header.text_size
+                || header.source_hash != source_hash(source))
+            return std::nullopt;
+
+        const auto text { image.substr(sizeof(format::Header) + tasks_size) };
+        const auto now { ClockT::local_time() };
+        std::map<std::tuple<format::Alignment, int, std::int64_t>, time_t>
+            first_times;
+        std::vector<Task> tasks;
+        tasks.reserve(header.tasks_count);
+        for (std::size_t i = 0; i < header.tasks_count; ++i) {
+            const auto compiled { detail::read_at<CompiledTask>(image,
+                    sizeof(format::Header) + i * sizeof(CompiledTask)) };
+            if (!detail::is_valid(compiled, text.size()))
+                return std::nullopt;
+            auto &task { tasks.emplace_back(to_task(compiled.record,
+                text.substr(compiled.command_offset, compiled.command_size),
+                text.substr(compiled.group_offset, compiled.group_size),
+                time_t(), 0)) };
+            task.alignment = compiled.alignment;
+            if (task.alignment == format::Alignment::CRON) {
+                task.time = first_time(task, now);
+                continue;
+            }
+            const auto key { std::make_tuple(task.alignment, task.anchor,
+                    splay_offset(task).total_seconds()) };
+            auto known { first_times.find(key) };
+            if (known == first_times.end())
+                known = first_times.emplace(key, first_time(task, now)).first;
+            task.time = known->second;
+        }
+        return tasks;
+    }
+
+    // Loads the compiled schedule next to the source, if it has one
+    template <typename ClockT>
+    std::optional<std::vector<Task>>
+    load_compiled(const std_filesystem::path &source_path,
+                  std::string_view source)
+    {
+        const auto path { compiled_path(source_path) };
+        if (!filesystem::detail::stamp_file(path))
+            return std::nullopt;
+        try {
+            const filesystem::detail::FileContents image(path);
+            return load<ClockT>(image.contents(), source);
+        } catch (const filesystem::error::FileNotFound &) {
+            return std::nullopt;
+        }
+    }
+
+    /*
+     * Compiles the source file next to it. The image is written aside
+     * and renamed over, so a running chronos never reads half of it.
+     */
+    template <typename TaskBuilderT>
+    std::size_t compile_file(const std_filesystem::path &source_path)
+    {
+        filesystem::detail::check_if_file_exist(source_path);
+        const filesystem::detail::FileContents source(source_path);
+        const auto image { compile<TaskBuilderT>(source.contents()) };
+        const auto path { compiled_path(source_path) };
+        auto written_path { path };
+        written_path += ".tmp";
+        {
+            std::ofstream file(written_path, std::ios::binary);
+            file.write(image.data(), image.size());
+            if (!file.flush())
+                throw error::CompilationNotWritten(path);
+        }
+        std::error_code renaming_error;
+        std_filesystem::rename(written_path, path, renaming_error);
+        if (renaming_error)
+            throw error::CompilationNotWritten(path);
+        return detail::read_at<format::Header>(image, 0).tasks_count;
+    }
+}
@@ -13,7 +13,10 @@ namespace chronos::coordinator
         using dispatcher_ptr_t = std::shared_ptr<DispatcherT>;
 
         explicit Coordinator(dispatcher_ptr_t dispatcher)
-            : dispatcher(dispatcher) { }
+            : dispatcher(dispatcher)
+        {
+            dispatcher->setWakeUp([this] () { timer.interrupt(); });
+        }
 
         void loopForever()
         {
@@ -23,6 +26,7 @@ namespace chronos::coordinator
 
         void terminate()
         {
+            dispatcher->setWakeUp(nullptr);
             terminated = true;
             timer.interrupt();
         }
@@ -32,7 +36,7 @@ namespace chronos::coordinator
         {
             timer.wait(dispatcher->timeToNextTask());
             if (!terminated)
-                dispatcher->handleNextTask();
+                dispatcher->handleDueTasks();
         }
 
         std::atomic<bool> terminated { false };
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstdint>
+#include "boost/date_time/gregorian/gregorian_types.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+
+namespace chronos::cron
+{
+    /*
+     * Cron expression compiled into one bit per allowed value of each
+     * field. Days of the month and months count from bit 1, days of the
+     * week from Sunday at bit 0. When both day fields are restricted a
+     * day matching either of them is a match, as in cron. An expression
+     * without minutes is none at all.
+     */
+    struct Expression
+    {
+        std::uint64_t minutes { 0 };
+        std::uint32_t hours { 0 };
+        std::uint32_t month_days { 0 };
+        std::uint16_t months { 0 };
+        std::uint8_t week_days { 0 };
+        bool either_day { false };
+
+        bool operator == (const Expression &other) const
+        {
+            return minutes == other.minutes && hours == other.hours
+                && month_days == other.month_days && months == other.months
+                && week_days == other.week_days
+                && either_day == other.either_day;
+        }
+    };
+
+    bool is_set(const Expression &expression)
+    {
+        return expression.minutes != 0;
+    }
+
+    // Whether every set bit stands for a value its field can take
+    bool is_valid(const Expression &expression)
+    {
+        constexpr std::uint16_t MONTHS_MASK { 0x1ffe };
+        return expression.minutes >> 60 == 0
+            && expression.hours >> 24 == 0
+            && (expression.month_days & 1) == 0
+            && (expression.months & ~MONTHS_MASK) == 0
+            && expression.week_days >> 7 == 0;
+    }
+}
+
+namespace chronos::cron::detail
+{
+    constexpr int DAYS_IN_WEEK { 7 };
+    constexpr int MONTHS_IN_YEAR { 12 };
+    // Any day of the month comes round within that many, even 29 February
+    constexpr int MAX_SEARCHED_MONTHS { 9 * MONTHS_IN_YEAR };
+
+    int lowest_bit(std::uint64_t mask)
+    {
+        return __builtin_ctzll(mask);
+    }
+
+    // Bits of the mask from the given one up
+    std::uint64_t from_bit(std::uint64_t mask, int bit)
+    {
+        return bit < 64 ? mask & (~std::uint64_t(0) << bit) : 0;
+    }
+
+    int days_in_month(int year, int month)
+    {
+        return boost::gregorian::gregorian_calendar::end_of_month_day(
+                year, month);
+    }
+
+    /*
+     * Days of the month matching the expression. Week days are rotated
+     * onto the first week of the month and repeated over the others.
+     */
+    std::uint64_t matching_days(const Expression &expression,
+                                int year, int month)
+    {
+        const int first_week_day {
+            boost::gregorian::date(year, month, 1).day_of_week() };
+        const std::uint64_t week_days { expression.week_days };
+        const auto first_week {
+            ((week_days >> first_week_day
+              | week_days << (DAYS_IN_WEEK - first_week_day)) & 0x7f) << 1 };
+        const auto by_week_day { first_week | first_week << 7
+            | first_week << 14 | first_week << 21 | first_week << 28 };
+        const std::uint64_t month_days { expression.month_days };
+        const auto days { expression.either_day
+            ? month_days | by_week_day : month_days & by_week_day };
+        const auto last_day { days_in_month(year, month) };
+        return days & (((std::uint64_t(1) << last_day) - 1) << 1);
+    }
+
+    // Whether the restricted days of the month fall in any allowed month
+    bool has_day(const Expression &expression)
+    {
+        constexpr int LEAP_YEAR { 2000 };
+        if (expression.either_day)
+            return true;
+        for (int month = 1; month <= MONTHS_IN_YEAR; ++month)
+            if (expression.months >> month & 1
+                    && from_bit(expression.month_days, 1)
+                       & ((std::uint64_t(1)
+                           << (days_in_month(LEAP_YEAR, month) + 1)) - 1))
+                return true;
+        return false;
+    }
+}
+
+namespace chronos::cron
+{
+    /*
+     * First minute after the given time matching the expression. Each
+     * field jumps straight to its next allowed value, the lowest set bit
+     * above the current one, and a field running out moves on the one
+     * above it. An expression which never matches gives positive
+     * infinity.
+     */
+    boost::posix_time::ptime next_fire(const Expression &expression,
+                                       const boost::posix_time::ptime &after)
+    {
+        using namespace detail;
+        if (after.is_special())
+            return after;
+        const auto date { after.date() };
+        const auto time_of_day { after.time_of_day() };
+        int year { date.year() };
+        int month { date.month() };
+        int day { date.day() };
+        int hour { static_cast<int>(time_of_day.hours()) };
+        int minute { static_cast<int>(time_of_day.minutes()) + 1 };
+
+        const auto next_month { [&] () {
+            const auto later { from_bit(expression.months, month + 1) };
+            if (later) {
+                month = lowest_bit(later);
+            } else {
+                ++year;
+                month = lowest_bit(expression.months);
+            }
+            day = 1;
+            hour = 0;
+            minute = 0;
+        } };
+
+        int searched_months { 0 };
+        while (searched_months < MAX_SEARCHED_MONTHS) {
+            if (!(expression.months >> month & 1)) {
+                next_month();
+                ++searched_months;
+                continue;
+            }
+            const auto days { from_bit(
+                    matching_days(expression, year, month), day) };
+            if (!days) {
+                next_month();
+                ++searched_months;
+                continue;
+            }
+            if (lowest_bit(days) != day) {
+                day = lowest_bit(days);
+                hour = 0;
+                minute = 0;
+            }
+            const auto hours { from_bit(expression.hours, hour) };
+            if (!hours) {
+                ++day;
+                hour = 0;
+                minute = 0;
+                continue;
+            }
+            if (lowest_bit(hours) != hour) {
+                hour = lowest_bit(hours);
+                minute = 0;
+            }
+            const auto minutes { from_bit(expression.minutes, minute) };
+            if (!minutes) {
+                ++hour;
+                minute = 0;
+                continue;
+            }
+            return boost::posix_time::ptime(
+                    boost::gregorian::date(year, month, day),
+                    boost::posix_time::hours(hour)
+                    + boost::posix_time::minutes(lowest_bit(minutes)));
+        }
+        return boost::posix_time::ptime(boost::posix_time::pos_infin);
+    }
+}
@@ -1,19 +1,289 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+namespace chronos::dispatcher
+{
+    /*
+     * Counts consecutive failures of every command. Once a command has
+     * failed the threshold number of times in a row its circuit opens
+     * and retries of it are suspended until the cool-down passes;
+     * scheduled runs still go on. A failure after the cool-down opens
+     * the circuit again, a success closes it. A task may set its own
+     * threshold and cool-down, the breaker's are used otherwise.
+     */
+    template <typename ClockT = std::chrono::steady_clock>
+    class CircuitBreaker
+    {
+    public:
+        using clock_t = ClockT;
+
+        static constexpr int FAILURE_THRESHOLD { 5 };
+        static constexpr std::chrono::minutes COOL_DOWN { 10 };
+
+        explicit CircuitBreaker(
+                int failure_threshold = FAILURE_THRESHOLD,
+                typename clock_t::duration cool_down = COOL_DOWN)
+            : failure_threshold(failure_threshold), cool_down(cool_down) { }
+
+        template <typename TaskT>
+        void record(const TaskT &task, bool success)
+        {
+            if (success) {
+                circuits.erase(task.command);
+                return;
+            }
+            auto &circuit { circuits[task.command] };
+            if (++circuit.failures >= failureThreshold(task))
+                circuit.opened = clock_t::now();
+        }
+
+        template <typename TaskT>
+        [[nodiscard]] bool allowsRetry(const TaskT &task) const
+        {
+            const auto circuit { circuits.find(task.command) };
+            return circuit == circuits.end()
+                || circuit->second.failures < failureThreshold(task)
+                || clock_t::now() - circuit->second.opened
+                   >= coolDown(task);
+        }
+
+    private:
+        struct Circuit
+        {
+            int failures { 0 };
+            typename clock_t::time_point opened;
+        };
+
+        template <typename TaskT>
+        [[nodiscard]] int failureThreshold(const TaskT &task) const
+        {
+            return task.circuit_failures > 0
+                ? task.circuit_failures : failure_threshold;
+        }
+
+        template <typename TaskT>
+        [[nodiscard]] typename clock_t::duration
+        coolDown(const TaskT &task) const
+        {
+            const std::chrono::seconds task_cool_down {
+                task.circuit_cool_down.total_seconds() };
+            return task_cool_down.count() > 0 ? task_cool_down : cool_down;
+        }
+
+        int failure_threshold;
+        typename clock_t::duration cool_down;
+        std::unordered_map<std::string, Circuit> circuits;
+    };
+}
 
 namespace chronos::dispatcher::detail
 {
-    template <typename ScheduleT>
-    void move_retries(std::shared_ptr<ScheduleT> &old,
-                      std::shared_ptr<ScheduleT> &new_)
+    template <typename ScheduleT, typename BreakerT, typename TaskT>
+    void conclude(ScheduleT &schedule, BreakerT &breaker, TaskT &task,
+                  bool execution_succeed)
     {
-        for (auto task = old->withdrawNextTask(); !old->isEmpty();
-            task = old->withdrawNextTask())
-            if (is_retry(task))
-                new_->add(task);
+        breaker.record(task, execution_succeed);
+        if (!execution_succeed && has_attempts_left(task)
+            && breaker.allowsRetry(task))
+            schedule.retry(task);
+        if (!is_retry(task))
+            schedule.reschedule(task);
     }
 }
 
+namespace chronos::dispatcher
+{
+    /*
+     * Admission queues of task groups. A due task of a limited group
+     * waits in the queue of its group until fewer than max_concurrent
+     * tasks of the group run and the token bucket of the group holds a
+     * start. The bucket refills at starts_per_second and holds at most
+     * one second worth of starts, but never less than one.
+     */
+    template <typename TaskT>
+    class GroupAdmission
+    {
+    public:
+        using clock_t = std::chrono::steady_clock;
+        using tasks_t = std::vector<TaskT>;
+
+        // Queues the task and returns whatever may start now
+        tasks_t offer(const TaskT &task)
+        {
+            if (task.group.name.empty())
+                return { task };
+            auto &group { groups[task.group.name] };
+            group.limits = task.group;
+            group.waiting.push_back(task);
+            tasks_t admitted;
+            admit(group, clock_t::now(), admitted);
+            return admitted;
+        }
+
+        // Frees the slot of a finished task, returns tasks started instead
+        tasks_t finish(const TaskT &task)
+        {
+            tasks_t admitted;
+            const auto group { groups.find(task.group.name) };
+            if (group == groups.end())
+                return admitted;
+            --group->second.running;
+            admit(group->second, clock_t::now(), admitted);
+            return admitted;
+        }
+
+        tasks_t admitWaiting()
+        {
+            tasks_t admitted;
+            const auto now { clock_t::now() };
+            for (auto &[name, group] : groups)
+                admit(group, now, admitted);
+            return admitted;
+        }
+
+        // Time until a queued task gets its start token, if one waits for it
+        [[nodiscard]] std::optional<clock_t::duration> timeToNextStart() const
+        {
+            std::optional<clock_t::time_point> next;
+            for (const auto &[name, group] : groups) {
+                if (group.waiting.empty() || !hasFreeSlot(group)
+                    || !isRateLimited(group))
+                    continue;
+                const std::chrono::duration<double> refill_time {
+                    (1 - group.tokens) / group.limits.starts_per_second };
+                const auto start { group.refilled
+                    + std::chrono::ceil<clock_t::duration>(refill_time) };
+                next = next ? std::min(*next, start) : start;
+            }
+            if (!next)
+                return std::nullopt;
+            return std::max(*next - clock_t::now(), clock_t::duration::zero());
+        }
+
+    private:
+        struct GroupState
+        {
+            decltype(TaskT::group) limits;
+            int running { 0 };
+            double tokens { 0 };
+            clock_t::time_point refilled;
+            std::deque<TaskT> waiting;
+        };
+
+        static bool hasFreeSlot(const GroupState &group)
+        {
+            return group.limits.max_concurrent <= 0
+                || group.running < group.limits.max_concurrent;
+        }
+
+        static bool isRateLimited(const GroupState &group)
+        {
+            return group.limits.starts_per_second > 0;
+        }
+
+        static void refill(GroupState &group, clock_t::time_point now)
+        {
+            const auto rate { group.limits.starts_per_second };
+            const std::chrono::duration<double> elapsed {
+                now - group.refilled };
+            group.tokens = std::min(std::max(1.0, rate),
+                                    group.tokens + elapsed.count() * rate);
+            group.refilled = now;
+        }
+
+        static void admit(GroupState &group, clock_t::time_point now,
+                          tasks_t &admitted)
+        {
+            if (isRateLimited(group))
+                refill(group, now);
+            while (!group.waiting.empty() && hasFreeSlot(group)) {
+                if (isRateLimited(group)) {
+                    if (group.tokens < 1)
+                        return;
+                    group.tokens -= 1;
+                }
+                ++group.running;
+                admitted.push_back(std::move(group.waiting.front()));
+                group.waiting.pop_front();
+            }
+        }
+
+        std::unordered_map<std::string, GroupState> groups;
+    };
+}
+
+namespace chronos::dispatcher
+{
+    /*
+     * Tasks waiting for a free execution slot, one queue per priority
+     * class. Classes take turns in proportion to their weights, which is
+     * weighted fair queueing for jobs of equal cost: every pick advances
+     * the pass of the class by the inverse of its weight and the class
+     * with the lowest pass goes next. A class coming back from idle
+     * starts at the current pass, so idling does not bank credit.
+     */
+    template <typename TaskT>
+    class FairQueue
+    {
+    public:
+        static constexpr std::array<double, 4> WEIGHTS { 1, 2, 4, 8 };
+
+        [[nodiscard]] bool empty() const
+        {
+            return !waiting_count;
+        }
+
+        void push(const TaskT &task)
+        {
+            auto &priority_class {
+                classes[static_cast<std::size_t>(task.priority)] };
+            if (priority_class.waiting.empty())
+                priority_class.pass = std::max(priority_class.pass, pass);
+            priority_class.waiting.push_back(task);
+            ++waiting_count;
+        }
+
+        TaskT pop()
+        {
+            std::size_t next { classes.size() };
+            for (std::size_t i = classes.size(); i-- > 0; )
+                if (!classes[i].waiting.empty() && (next == classes.size()
+                        || classes[i].pass < classes[next].pass))
+                    next = i;
+            auto &priority_class { classes[next] };
+            pass = priority_class.pass;
+            priority_class.pass += 1 / WEIGHTS[next];
+            auto task { std::move(priority_class.waiting.front()) };
+            priority_class.waiting.pop_front();
+            --waiting_count;
+            return task;
+        }
+
+    private:
+        struct PriorityClass
+        {
+            double pass { 0 };
+            std::deque<TaskT> waiting;
+        };
+
+        std::array<PriorityClass, WEIGHTS.size()> classes;
+        double pass { 0 };
+        std::size_t waiting_count { 0 };
+    };
+}
+
 namespace chronos
 {
     template <typename ScheduleT, typename ExecuteT>
@@ -23,6 +293,9 @@ namespace chronos
         using schedule_t = ScheduleT;
         using schedule_ptr_t = std::shared_ptr<schedule_t>;
         using time_duration_t = typename ScheduleT::duration_t;
+        using task_t = typename ScheduleT::task_t;
+        using tasks_t = std::vector<task_t>;
+        using wake_up_t = std::function<void()>;
 
         explicit Dispatcher(schedule_ptr_t schedule) : schedule(schedule) { }
 
@@ -34,22 +307,174 @@ namespace chronos
         void handleNextTask()
         {
             auto task { schedule->withdrawNextTask() };
-            const auto execution_response { execute(task.command) };
-            const bool execution_succeed { execution_response.success };
-            if (!execution_succeed && has_attempts_left(task))
-                schedule->retry(task);
-            if (!is_retry(task))
-                schedule->reschedule(task);
+            handle(task);
+        }
+
+        void handleDueTasks()
+        {
+            for (auto &task : schedule->withdrawDueTasks())
+                handle(task);
         }
 
-        void reload(schedule_ptr_t new_schedule)
+        auto reload(const tasks_t &tasks)
         {
-            dispatcher::detail::move_retries(schedule, new_schedule);
-            schedule = new_schedule;
+            return schedule->reload(tasks);
         }
 
+        // Schedule changes only on the coordinator thread, nobody to wake
+        void setWakeUp(wake_up_t) { }
+
+        // Tasks run one at a time anyway
+        void setCapacity(std::size_t) { }
+
     private:
+        void handle(task_t &task)
+        {
+            const auto execution_response { execute(task) };
+            dispatcher::detail::conclude(*schedule, breaker, task,
+                                         execution_response.success);
+        }
+
         ExecuteT execute;
         schedule_ptr_t schedule;
+        dispatcher::CircuitBreaker<> breaker;
+    };
+
+    /*
+     * Hands due tasks over to an asynchronous execution and returns
+     * immediately. Completions arrive on worker threads, update the
+     * schedule under the dispatcher lock and wake the coordinator up,
+     * since a retry may be due before the task it was waiting for.
+     * Tasks of limited groups pass through group admission first. With
+     * a capacity set, tasks beyond it wait for a free slot and are
+     * started in weighted fair order of their priorities.
+     */
+    template <typename ScheduleT, typename ExecuteT>
+    class AsyncDispatcher
+    {
+    public:
+        using schedule_t = ScheduleT;
+        using schedule_ptr_t = std::shared_ptr<schedule_t>;
+        using time_duration_t = typename ScheduleT::duration_t;
+        using task_t = typename ScheduleT::task_t;
+        using tasks_t = std::vector<task_t>;
+        using wake_up_t = std::function<void()>;
+        using response_t = typename ExecuteT::response_t;
+
+        template <typename ...ArgsT>
+        explicit AsyncDispatcher(schedule_ptr_t schedule, ArgsT &&...args)
+            : schedule(schedule),
+            execute(std::forward<ArgsT>(args)...) { }
+
+        time_duration_t timeToNextTask() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto next_task { schedule->timeToNextTask() };
+            const auto next_start { admission.timeToNextStart() };
+            if (!next_start)
+                return next_task;
+            const auto microseconds { std::chrono::ceil<
+                    std::chrono::microseconds>(*next_start).count() };
+            return std::min(next_task, time_duration_t(
+                    boost::posix_time::microseconds(microseconds)));
+        }
+
+        void handleNextTask()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            const auto started {
+                start(admission.offer(schedule->withdrawNextTask())) };
+            lock.unlock();
+            submit(started);
+        }
+
+        void handleDueTasks()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto admitted { admission.admitWaiting() };
+            for (const auto &task : schedule->withdrawDueTasks()) {
+                const auto admitted_task { admission.offer(task) };
+                admitted.insert(end(admitted), begin(admitted_task),
+                                end(admitted_task));
+            }
+            const auto started { start(admitted) };
+            lock.unlock();
+            submit(started);
+        }
+
+        /*
+         * New definitions are indexed before taking the lock, so due
+         * tasks keep being dispatched meanwhile. The coordinator is woken
+         * up since a new task may be due before the one it waits for.
+         */
+        auto reload(const tasks_t &tasks)
+        {
+            typename schedule_t::reload_plan_t plan(tasks);
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto summary { schedule->reload(plan) };
+            if (wake_up)
+                wake_up();
+            return summary;
+        }
+
+        void setWakeUp(wake_up_t callback)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake_up = callback;
+        }
+
+        // Limits how many tasks run at once, zero means no limit
+        void setCapacity(std::size_t slots)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            capacity = slots;
+            const auto started { start({}) };
+            lock.unlock();
+            submit(started);
+        }
+
+    private:
+        // Queues admitted tasks and takes those fitting in free slots
+        tasks_t start(const tasks_t &admitted)
+        {
+            for (const auto &task : admitted)
+                ready.push(task);
+            tasks_t started;
+            while (!ready.empty() && (!capacity || running < capacity)) {
+                started.push_back(ready.pop());
+                ++running;
+            }
+            return started;
+        }
+
+        void submit(const tasks_t &tasks)
+        {
+            for (const auto &task : tasks)
+                execute(task, [this, task] (const response_t &response) {
+                    complete(task, response); });
+        }
+
+        void complete(task_t task, const response_t &response)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            --running;
+            const auto started { start(admission.finish(task)) };
+            dispatcher::detail::conclude(*schedule, breaker, task,
+                                         response.success);
+            if (wake_up)
+                wake_up();
+            lock.unlock();
+            submit(started);
+        }
+
+        mutable std::mutex mutex;
+        schedule_ptr_t schedule;
+        dispatcher::GroupAdmission<task_t> admission;
+        dispatcher::FairQueue<task_t> ready;
+        dispatcher::CircuitBreaker<> breaker;
+        std::size_t capacity { 0 };
+        std::size_t running { 0 };
+        wake_up_t wake_up;
+        ExecuteT execute;
     };
 }
@@ -0,0 +1,98 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace chronos::execution
+{
+    class WorkerPool
+    {
+    public:
+        using job_t = std::function<void()>;
+
+        explicit WorkerPool(std::size_t workers_count)
+        {
+            for (std::size_t i = 0; i < workers_count; ++i)
+                workers.emplace_back([this] () { work(); });
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            job_available.notify_all();
+            for (auto &worker : workers)
+                worker.join();
+        }
+
+        void submit(job_t job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            job_available.notify_one();
+        }
+
+    private:
+        void work()
+        {
+            while (true) {
+                job_t job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    job_available.wait(lock, [this] () {
+                        return stopped || !jobs.empty(); });
+                    if (jobs.empty())
+                        return;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable job_available;
+        std::deque<job_t> jobs;
+        bool stopped { false };
+        std::vector<std::thread> workers;
+    };
+}
+
+namespace chronos
+{
+    /*
+     * Runs a synchronous execution on a bounded pool of workers and
+     * reports the response through a callback on the worker thread.
+     */
+    template <typename ExecuteT>
+    class AsyncExecution
+    {
+    public:
+        using response_t = typename ExecuteT::response_t;
+        using callback_t = std::function<void(const response_t&)>;
+
+        explicit AsyncExecution(std::size_t workers_count)
+            : pool(workers_count) { }
+
+        template <typename TaskT>
+        void operator () (const TaskT &task, callback_t callback)
+        {
+            pool.submit([task, callback] () {
+                // Executions keep the output of their last run, one each
+                thread_local ExecuteT execute;
+                callback(execute(task)); });
+        }
+
+    private:
+        execution::WorkerPool pool;
+    };
+}
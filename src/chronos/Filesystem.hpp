@@ -1,9 +1,23 @@
 #pragma once
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <fstream>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <variant>
+#include <vector>
 #include "fmt/core.h"
 
 #if __GNUC__ > 7
@@ -34,102 +48,543 @@ namespace chronos::filesystem::detail
             throw error::FileNotFound(path);
     }
 
-    std::string read_file_content(const std_filesystem::path &path)
+    /*
+     * Identity of a version of a file, as far as stat can tell. A save
+     * changes at least one of these, so equal stamps spare reading the
+     * file again.
+     */
+    struct FileStamp
     {
-        std::ifstream file;
-        file.open(path);
-        std::ostringstream string_stream;
-        string_stream << file.rdbuf();
-        std::string content { string_stream.str() };
-        return content;
+        ino_t inode { 0 };
+        off_t size { -1 };
+        std::int64_t mtime_ns { 0 };
+
+        bool operator == (const FileStamp &other) const
+        {
+            return inode == other.inode && size == other.size
+                && mtime_ns == other.mtime_ns;
+        }
+    };
+
+    std::optional<FileStamp> stamp_file(const std_filesystem::path &path)
+    {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0)
+            return std::nullopt;
+        constexpr std::int64_t NANOSECONDS_PER_SECOND { 1000000000 };
+        return FileStamp { status.st_ino, status.st_size,
+            status.st_mtim.tv_sec * NANOSECONDS_PER_SECOND
+            + status.st_mtim.tv_nsec };
+    }
+
+    /*
+     * Whole contents of a file, read front to back into a buffer of its
+     * size. The kernel is told so and reads ahead. The file is not mapped,
+     * as an editor truncating it in place would fault the parse.
+     */
+    class FileContents
+    {
+    public:
+        explicit FileContents(const std_filesystem::path &path)
+        {
+            const int descriptor { open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+            if (descriptor < 0)
+                throw error::FileNotFound(path);
+            struct stat status;
+            const bool readable { fstat(descriptor, &status) == 0
+                                  && readAll(descriptor, status.st_size) };
+            close(descriptor);
+            if (!readable)
+                throw error::FileNotFound(path);
+        }
+
+        [[nodiscard]] std::string_view contents() const
+        {
+            return text;
+        }
+
+    private:
+        static constexpr std::size_t MIN_READ_SIZE { 4096 };
+
+        // A byte to spare lets the read telling the end fit in
+        bool readAll(int descriptor, off_t expected_size)
+        {
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+            text.resize(std::max<off_t>(expected_size, 0) + 1);
+            std::size_t filled { 0 };
+            while (true) {
+                if (filled == text.size())
+                    text.resize(std::max(text.size() * 2, MIN_READ_SIZE));
+                const auto count { read(descriptor, text.data() + filled,
+                                        text.size() - filled) };
+                if (count > 0)
+                    filled += count;
+                else if (!count)
+                    break;
+                else if (errno != EINTR)
+                    return false;
+            }
+            text.resize(filled);
+            return true;
+        }
+
+        std::string text;
+    };
+
+    /*
+     * A schedule directory is made of the files in it with this
+     * extension, merged in the order of their names.
+     */
+    constexpr std::string_view FRAGMENT_EXTENSION { ".chronos" };
+
+    bool is_fragment(const std_filesystem::path &path)
+    {
+        return path.extension() == FRAGMENT_EXTENSION;
     }
 
-    size_t calculate_file_hash(const std_filesystem::path &path)
+    std::vector<std_filesystem::path>
+    list_fragments(const std_filesystem::path &directory)
     {
-        check_if_file_exist(path);
-        const auto content { read_file_content(path) };
-        std::hash<std::string> hash;
-        return hash(content);
+        std::vector<std_filesystem::path> fragments;
+        std::error_code error;
+        for (const auto &entry
+                : std_filesystem::directory_iterator(directory, error))
+            if (is_fragment(entry.path())
+                    && std_filesystem::is_regular_file(entry.path(), error))
+                fragments.push_back(entry.path());
+        std::sort(begin(fragments), end(fragments));
+        return fragments;
+    }
+
+    // Murmur based hash of the standard library, hashed in place
+    size_t calculate_content_hash(std::string_view content)
+    {
+        return std::hash<std::string_view>()(content);
     }
 }
 
 namespace chronos::filesystem::guard
 {
+    /*
+     * Tells whether the contents of a file changed since the last check.
+     * The file is hashed only when its stamp differs from the last one,
+     * and the contents hashed are kept for the parse which follows.
+     */
     class FileGuard
     {
     public:
+        using contents_t = std::shared_ptr<const detail::FileContents>;
+
         explicit FileGuard(const std_filesystem::path &path)
-            : path(path),
-            previous_hash(detail::calculate_file_hash(path)) { }
+            : path(path)
+        {
+            detail::check_if_file_exist(path);
+            checkForChange();
+            contents.reset();
+        }
 
         bool checkForChange()
         {
-            const auto current_hash { detail::calculate_file_hash(path) };
-            const bool changed { current_hash != previous_hash };
+            // Mid-save, an editor may have removed the file for a moment
+            const auto stamp { detail::stamp_file(path) };
+            if (!stamp || *stamp == previous_stamp)
+                return false;
+            auto current { std::make_shared<const detail::FileContents>(path) };
+            const auto current_hash {
+                detail::calculate_content_hash(current->contents()) };
+            previous_stamp = *stamp;
+            if (current_hash == previous_hash)
+                return false;
             previous_hash = current_hash;
-            return changed;
+            contents = std::move(current);
+            return true;
+        }
+
+        // Contents found by the last check reporting a change, if any
+        contents_t takeContents()
+        {
+            return std::exchange(contents, nullptr);
         }
 
     private:
         std_filesystem::path path;
-        size_t previous_hash;
+        detail::FileStamp previous_stamp;
+        size_t previous_hash { 0 };
+        contents_t contents;
+    };
+}
+
+namespace chronos::filesystem::guard
+{
+    /*
+     * Tells whether any fragment of a schedule directory was added,
+     * removed or saved since the last check. Only the stamps of the
+     * fragments are compared; their contents are left to the reader.
+     */
+    class DirectoryGuard
+    {
+    public:
+        explicit DirectoryGuard(const std_filesystem::path &directory)
+            : directory(directory),
+            previous_stamps(stampFragments()) { }
+
+        bool checkForChange()
+        {
+            auto stamps { stampFragments() };
+            const bool changed { stamps != previous_stamps };
+            previous_stamps = std::move(stamps);
+            return changed;
+        }
+
+        // Fragments are read by the reader, which caches them by content
+        FileGuard::contents_t takeContents()
+        {
+            return nullptr;
+        }
+
+    private:
+        using stamps_t = std::map<std_filesystem::path, detail::FileStamp>;
+
+        stamps_t stampFragments() const
+        {
+            stamps_t stamps;
+            for (const auto &fragment : detail::list_fragments(directory))
+                if (const auto stamp { detail::stamp_file(fragment) })
+                    stamps.emplace(fragment, *stamp);
+            return stamps;
+        }
+
+        std_filesystem::path directory;
+        stamps_t previous_stamps;
+    };
+
+    using guard_t = std::variant<FileGuard, DirectoryGuard>;
+
+    guard_t make_guard(const std_filesystem::path &path)
+    {
+        detail::check_if_file_exist(path);
+        if (std_filesystem::is_directory(path))
+            return guard_t(std::in_place_type<DirectoryGuard>, path);
+        return guard_t(std::in_place_type<FileGuard>, path);
+    }
+}
+
+namespace chronos::filesystem::watcher
+{
+    /*
+     * Watches the directory of a file for events concerning the file.
+     * Watching the directory rather than the file itself keeps working
+     * across saves replacing the file by renaming a new one over it.
+     * A schedule directory is watched for events concerning fragments.
+     */
+    class FileWatcher
+    {
+    public:
+        explicit FileWatcher(const std_filesystem::path &path)
+            : file_name(path.filename()),
+            whole_directory(std_filesystem::is_directory(path)),
+            inotify(inotify_init1(IN_CLOEXEC | IN_NONBLOCK)),
+            wake_up(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        {
+            const auto directory { whole_directory ? path
+                : path.has_parent_path() ? path.parent_path()
+                : std_filesystem::path(".") };
+            if (inotify >= 0)
+                watch = inotify_add_watch(inotify, directory.c_str(),
+                                          WATCHED_EVENTS);
+        }
+
+        ~FileWatcher()
+        {
+            if (inotify >= 0)
+                close(inotify);
+            if (wake_up >= 0)
+                close(wake_up);
+        }
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator = (const FileWatcher&) = delete;
+
+        [[nodiscard]] bool isActive() const
+        {
+            return inotify >= 0 && wake_up >= 0 && watch >= 0;
+        }
+
+        /*
+         * Blocks until the file was touched and then left alone for the
+         * debounce window, so that a save written in several steps is
+         * reported once. Returns false when interrupted.
+         */
+        bool waitForChange()
+        {
+            bool touched { false };
+            while (isActive()) {
+                std::array<pollfd, 2> descriptors { {
+                    { inotify, POLLIN, 0 }, { wake_up, POLLIN, 0 } } };
+                const auto ready { poll(descriptors.data(),
+                                        descriptors.size(),
+                                        touched ? DEBOUNCE_WINDOW_MS : -1) };
+                if (ready < 0 && errno != EINTR)
+                    return false;
+                if (!ready)
+                    return true;
+                if (descriptors[1].revents) {
+                    std::uint64_t value;
+                    [[maybe_unused]] const auto read_count {
+                        read(wake_up, &value, sizeof(value)) };
+                    return false;
+                }
+                if (descriptors[0].revents && readEvents())
+                    touched = true;
+            }
+            return touched;
+        }
+
+        void interrupt()
+        {
+            const std::uint64_t increment { 1 };
+            [[maybe_unused]] const auto written {
+                write(wake_up, &increment, sizeof(increment)) };
+        }
+
+    private:
+        static constexpr std::uint32_t WATCHED_EVENTS {
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE
+            | IN_DELETE | IN_MODIFY };
+        static constexpr int DEBOUNCE_WINDOW_MS { 200 };
+        static constexpr std::size_t EVENTS_BUFFER_SIZE { 4096 };
+
+        // Returns whether any of the pending events concerns the file
+        bool readEvents()
+        {
+            alignas(inotify_event) std::array<char, EVENTS_BUFFER_SIZE> buffer;
+            bool concerned { false };
+            while (true) {
+                const auto count { read(inotify, buffer.data(),
+                                        buffer.size()) };
+                if (count <= 0)
+                    return concerned;
+                for (auto position { buffer.data() };
+                     position < buffer.data() + count; ) {
+                    const auto event {
+                        reinterpret_cast<const inotify_event*>(position) };
+                    if (event->mask & IN_Q_OVERFLOW)
+                        concerned = true;
+                    else if (event->mask & IN_IGNORED)
+                        watch = -1;
+                    else if (event->len && concerns(event->name))
+                        concerned = true;
+                    position += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+        bool concerns(const char *name) const
+        {
+            return whole_directory ? detail::is_fragment(name)
+                : file_name == name;
+        }
+
+        std::string file_name;
+        bool whole_directory;
+        int inotify;
+        int wake_up;
+        int watch { -1 };
     };
 }
 
 namespace chronos::filesystem::reader
 {
-    template <typename ParserT, typename ScheduleT>
-    class FileReader
+    /*
+     * Fragments sharing a group without limits of their own take the
+     * limits of the group defined in another fragment.
+     */
+    template <typename TasksT>
+    void share_group_limits(TasksT &tasks)
+    {
+        const auto has_limits { [] (const auto &task) {
+            return task.group.max_concurrent > 0
+                || task.group.starts_per_second > 0; } };
+        std::unordered_map<std::string, std::size_t> limited;
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+            if (has_limits(tasks[i]))
+                limited.emplace(tasks[i].group.name, i);
+        for (auto &task : tasks) {
+            const auto group { limited.find(task.group.name) };
+            if (group != limited.end() && !has_limits(task))
+                task.group = tasks[group->second].group;
+        }
+    }
+
+    /*
+     * Reads a schedule directory. Parsed fragments are cached under the
+     * hash of their contents, and a fragment is read again only when its
+     * stamp changed, so a reload parses just the saved fragments. Cached
+     * tasks are aligned again on every read, as their first times pass.
+     */
+    template <typename ParserT>
+    class DirectoryReader
     {
     public:
-        std::shared_ptr<ScheduleT> read(const std_filesystem::path &path)
+        using result_t = typename ParserT::result_t;
+
+        result_t read(const std_filesystem::path &directory)
+        {
+            filesystem::detail::check_if_file_exist(directory);
+            result_t result;
+            std::unordered_map<std::string, Fragment> fragments;
+            std::unordered_map<size_t, result_t> parsed;
+            const auto now { ParserT::clock_t::local_time() };
+            for (const auto &path : detail::list_fragments(directory)) {
+                auto file { readFragment(path) };
+                const auto &fragment { file.fragment };
+                auto cached { parsed_fragments.find(fragment.hash) };
+                if (cached == parsed_fragments.end()) {
+                    if (!file.contents)
+                        file.contents.emplace(path);
+                    cached = parsed_fragments.emplace(fragment.hash,
+                        parser.parse(file.contents->contents())).first;
+                } else {
+                    for (auto &task : cached->second)
+                        task.time = first_time(task, now);
+                }
+                result.insert(end(result), begin(cached->second),
+                              end(cached->second));
+                parsed.emplace(*cached);
+                fragments.emplace(path, fragment);
+            }
+            known_fragments = std::move(fragments);
+            parsed_fragments = std::move(parsed);
+            share_group_limits(result);
+            return result;
+        }
+
+    private:
+        struct Fragment
+        {
+            detail::FileStamp stamp;
+            size_t hash;
+        };
+
+        // Contents are kept when read, for a changed fragment to be parsed
+        struct FragmentFile
+        {
+            Fragment fragment;
+            std::optional<detail::FileContents> contents;
+        };
+
+        FragmentFile readFragment(const std_filesystem::path &path) const
+        {
+            const auto stamp { detail::stamp_file(path) };
+            const auto known { known_fragments.find(path) };
+            if (stamp && known != known_fragments.end()
+                    && known->second.stamp == *stamp)
+                return { known->second, std::nullopt };
+            std::optional<detail::FileContents> file(std::in_place, path);
+            return { { stamp.value_or(detail::FileStamp()),
+                       detail::calculate_content_hash(file->contents()) },
+                     std::move(file) };
+        }
+
+        ParserT parser;
+        std::unordered_map<std::string, Fragment> known_fragments;
+        std::unordered_map<size_t, result_t> parsed_fragments;
+    };
+
+    template <typename ParserT>
+    class TaskReader
+    {
+    public:
+        typename ParserT::result_t read(const std_filesystem::path &path)
         {
             filesystem::detail::check_if_file_exist(path);
-            const auto content { filesystem::detail::read_file_content(path) };
-            const auto schedule { parseContent(content) };
-            return schedule;
+            if (std_filesystem::is_directory(path))
+                return directory_reader.read(path);
+            const filesystem::detail::FileContents file(path);
+            return parser.parse(file.contents());
         }
 
     private:
-        std::shared_ptr<ScheduleT> parseContent(const std::string &content)
+        ParserT parser;
+        DirectoryReader<ParserT> directory_reader;
+    };
+
+    template <typename ParserT, typename ScheduleT>
+    class FileReader
+    {
+    public:
+        std::shared_ptr<ScheduleT> read(const std_filesystem::path &path)
         {
             auto schedule { std::make_shared<ScheduleT>() };
-            for (const auto &task : parser.parse(content))
+            for (const auto &task : reader.read(path))
                 schedule->add(task);
             return schedule;
         }
 
-        ParserT parser;
+    private:
+        TaskReader<ParserT> reader;
     };
 }
 
 namespace chronos
 {
+    /*
+     * Blocks until the contents of the file, or of the fragments of the
+     * directory, change. Changes are noticed through inotify as they
+     * happen; the file is polled every check interval only when inotify
+     * cannot be used.
+     */
     template <typename TimerT>
     class FileLock
     {
     public:
-        explicit FileLock(const std_filesystem::path &path) : guard(path) { }
+        explicit FileLock(const std_filesystem::path &path)
+            : guard(filesystem::guard::make_guard(path)), watcher(path) { }
 
         void waitUntilChange(const typename TimerT::duration_t &check_interval)
         {
-            released = false;
-            while (!guard.checkForChange() && !released)
+            while (watcher.isActive() && !released)
+                if (watcher.waitForChange() && checkForChange())
+                    return;
+            while (!released && !checkForChange())
                 timer.wait(check_interval);
         }
 
+        // Contents of the change the last wait returned on, if any
+        filesystem::guard::FileGuard::contents_t takeChange()
+        {
+            return std::visit([] (auto &guard) {
+                return guard.takeContents(); }, guard);
+        }
+
+        // Ends the current wait and every later one
         void release()
         {
             released = true;
+            watcher.interrupt();
             timer.interrupt();
         }
 
     private:
+        bool checkForChange()
+        {
+            return std::visit([] (auto &guard) {
+                return guard.checkForChange(); }, guard);
+        }
+
         TimerT timer;
-        filesystem::guard::FileGuard guard;
+        filesystem::guard::guard_t guard;
+        filesystem::watcher::FileWatcher watcher;
         std::atomic<bool> released { false };
     };
 
+    template <typename ParserT>
+    typename ParserT::result_t read_tasks_file(const std_filesystem::path &path)
+    {
+        filesystem::reader::TaskReader<ParserT> reader;
+        return reader.read(path);
+    }
+
     template <typename ParserT, typename ScheduleT>
     std::shared_ptr<ScheduleT>
     read_schedule_file(const std_filesystem::path &path)
@@ -1,4 +1,7 @@
 #pragma once
+#include <optional>
+#include <string_view>
+#include <vector>
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "fmt/core.h"
 #include "spdlog/pattern_formatter.h"
@@ -130,16 +133,39 @@ namespace chronos::logging::schedule
         log(message);
     }
 
+    template <typename HandleT>
+    void log_cancelled_task(const HandleT &handle)
+    {
+        const std::string message { fmt::format(
+                "Cancelled task with handle: {}", handle) };
+        log(message);
+    }
+
+    template <typename HandleT, typename TimeT>
+    void log_updated_task(const HandleT &handle, const TimeT &time)
+    {
+        using namespace boost::posix_time;
+        const auto task_time_string { to_simple_string(time) };
+        const std::string message { fmt::format(
+                "Updated task with handle: {} to be executed at: {}",
+                handle, task_time_string) };
+        log(message);
+    }
+
     template <typename TaskT>
     void log_before_retry(const TaskT &task)
     {
+        using boost::posix_time::to_simple_string;
         const auto retries_left {
             task.max_retries_count - task.attempts_count };
+        const auto time_to_retry { task.backoff_limit.total_seconds() > 0
+            ? fmt::format("backoff up to {}",
+                          to_simple_string(task.backoff_limit))
+            : to_simple_string(task.retry_after) };
         const std::string message { fmt::format(
                 "Task \"{}\" will be retried (retries left: {})."
                 " Time to retry: {}",
-                task.command, retries_left,
-                boost::posix_time::to_simple_string(task.retry_after)) };
+                task.command, retries_left, time_to_retry) };
         log(message);
     }
 }
@@ -153,46 +179,84 @@ namespace chronos::logging::system
         log(message);
     }
 
-    void append_system_response(std::string &src,
-                                const std::string &system_response)
+    template <typename ResponseT>
+    void append_system_response(std::string &src, const ResponseT &response)
     {
+        const std::string_view output { response.message };
+        if (!response.dropped_bytes) {
+            src.append(fmt::format("\nSystem message: {}", output));
+            return;
+        }
         src.append(fmt::format(
-                "\nSystem message: {}", system_response));
+                "\nSystem message: {}\n[... {} bytes dropped ...]\n{}",
+                output.substr(0, response.dropped_at),
+                response.dropped_bytes,
+                output.substr(response.dropped_at)));
     }
 
+    template <typename ResponseT>
     void log_after_successful_execution(const std::string &command,
-                                        const std::string &response_message)
+                                        const ResponseT &response)
     {
-        std::string message { "Execution succeed" };
-        if (!response_message.empty())
-            append_system_response(message, response_message);
+        std::string message { fmt::format(
+                "Execution of \"{}\" succeed", command) };
+        if (!response.message.empty())
+            append_system_response(message, response);
         log(message);
     }
 
+    template <typename ResponseT>
     void log_after_failed_execution(const std::string &command,
-                                    const std::string &response_message)
+                                    const ResponseT &response)
     {
-        std::string message { "Execution failed" };
-        if (!response_message.empty())
-            append_system_response(message, response_message);
+        std::string message { fmt::format(
+                "Execution of \"{}\" {}", command,
+                response.timed_out ? "timed out" : "failed") };
+        if (!response.message.empty())
+            append_system_response(message, response);
         log(message);
     }
 }
 
+namespace chronos::logging::system
+{
+    template <typename ResponseT>
+    void log_execution_response(const std::string &command,
+                                const ResponseT &response)
+    {
+        if (response.success)
+            log_after_successful_execution(command, response);
+        else
+            log_after_failed_execution(command, response);
+    }
+}
+
 namespace chronos::logging::parser
 {
-    void log_parsing_error()
+    void log_parsing_error(const std::string &reason)
     {
-        std::string message { "Parsing source file failed" };
+        const std::string message { fmt::format(
+                "Parsing source file failed: {}", reason) };
+        log(message);
+    }
+
+    void log_compiled_schedule_loaded(std::size_t tasks_count)
+    {
+        const std::string message { fmt::format(
+                "Compiled schedule loaded ({} tasks)", tasks_count) };
         log(message);
     }
 }
 
 namespace chronos::logging::dispatcher
 {
-    void log_reload()
+    template <typename SummaryT>
+    void log_reload(const SummaryT &summary)
     {
-        std::string message { "Schedule has been reloaded" };
+        const std::string message { fmt::format(
+                "Schedule has been reloaded (kept: {}, added: {},"
+                " removed: {})",
+                summary.kept, summary.added, summary.removed) };
         log(message);
     }
 }
@@ -205,16 +269,20 @@ namespace chronos
     public:
         using task_t = typename WrapeeT::task_t;
         using duration_t = typename WrapeeT::duration_t;
+        using handle_t = typename WrapeeT::handle_t;
+        using time_t = typename WrapeeT::time_t;
+        using reload_plan_t = typename WrapeeT::reload_plan_t;
 
         [[nodiscard]] bool isEmpty() const
         {
             return wrapee.isEmpty();
         }
 
-        void add(const typename WrapeeT::task_t &task)
+        handle_t add(const typename WrapeeT::task_t &task)
         {
-            wrapee.add(task);
+            const auto handle { wrapee.add(task) };
             logging::schedule::log_added_task(task);
+            return handle;
         }
 
         void reschedule(typename WrapeeT::task_t &task)
@@ -229,11 +297,52 @@ namespace chronos
             wrapee.retry(task);
         }
 
+        auto reload(const std::vector<task_t> &tasks)
+        {
+            return wrapee.reload(tasks);
+        }
+
+        auto reload(reload_plan_t &plan)
+        {
+            return wrapee.reload(plan);
+        }
+
+        bool cancel(handle_t handle)
+        {
+            const bool cancelled { wrapee.cancel(handle) };
+            if (cancelled)
+                logging::schedule::log_cancelled_task(handle);
+            return cancelled;
+        }
+
+        bool update(handle_t handle, const time_t &time)
+        {
+            const bool updated { wrapee.update(handle, time) };
+            if (updated)
+                logging::schedule::log_updated_task(handle, time);
+            return updated;
+        }
+
+        [[nodiscard]] std::optional<task_t> find(handle_t handle) const
+        {
+            return wrapee.find(handle);
+        }
+
         [[nodiscard]] typename WrapeeT::duration_t timeToNextTask() const
         {
             return wrapee.timeToNextTask();
         }
 
+        std::vector<task_t> withdrawDueTasks(const time_t &now)
+        {
+            return wrapee.withdrawDueTasks(now);
+        }
+
+        std::vector<task_t> withdrawDueTasks()
+        {
+            return wrapee.withdrawDueTasks();
+        }
+
         typename WrapeeT::task_t withdrawNextTask()
         {
             return wrapee.withdrawNextTask();
@@ -249,16 +358,12 @@ namespace chronos
     public:
         using response_t = typename WrapeeT::response_t;
 
-        response_t operator () (const std::string &command)
+        template <typename TaskT>
+        response_t operator () (const TaskT &task)
         {
-            logging::system::log_before_command_execution(command);
-            const auto response { wrapee(command) };
-            if (response.success)
-                logging::system::log_after_successful_execution(command,
-                                                            response.message);
-            else
-                logging::system::log_after_failed_execution(command,
-                                                            response.message);
+            logging::system::log_before_command_execution(task.command);
+            const auto response { wrapee(task) };
+            logging::system::log_execution_response(task.command, response);
             return response;
         }
 
@@ -266,16 +371,44 @@ namespace chronos
         WrapeeT wrapee;
     };
 
+    template <typename WrapeeT>
+    class AsyncSystemCallLoggingProxy
+    {
+    public:
+        using response_t = typename WrapeeT::response_t;
+        using callback_t = typename WrapeeT::callback_t;
+
+        template <typename ...ArgsT>
+        explicit AsyncSystemCallLoggingProxy(ArgsT &&...args)
+            : wrapee(std::forward<ArgsT>(args)...) { }
+
+        template <typename TaskT>
+        void operator () (const TaskT &task, callback_t callback)
+        {
+            const auto &command { task.command };
+            logging::system::log_before_command_execution(command);
+            wrapee(task, [command, callback] (const response_t &response) {
+                logging::system::log_execution_response(command, response);
+                callback(response); });
+        }
+
+    private:
+        WrapeeT wrapee;
+    };
+
     template <typename WrapeeT>
     class ParserLoggingProxy
     {
     public:
-        typename WrapeeT::result_t parse(const std::string &input)
+        using result_t = typename WrapeeT::result_t;
+        using clock_t = typename WrapeeT::clock_t;
+
+        typename WrapeeT::result_t parse(std::string_view input)
         {
             try {
                 return wrapee.parse(input);
             } catch (const std::exception &error) {
-                logging::parser::log_parsing_error();
+                logging::parser::log_parsing_error(error.what());
                 throw;
             }
         }
@@ -289,9 +422,13 @@ namespace chronos
     public:
         using schedule_ptr_t = typename WrapeeT::schedule_ptr_t;
         using time_duration_t = typename WrapeeT::time_duration_t;
+        using tasks_t = typename WrapeeT::tasks_t;
+        using wake_up_t = typename WrapeeT::wake_up_t;
 
-        explicit DispatcherLoggingProxy(schedule_ptr_t schedule)
-            : wrapee(schedule) { }
+        template <typename ...ArgsT>
+        explicit DispatcherLoggingProxy(schedule_ptr_t schedule,
+                                        ArgsT &&...args)
+            : wrapee(schedule, std::forward<ArgsT>(args)...) { }
 
         time_duration_t timeToNextTask() const
         {
@@ -303,10 +440,26 @@ namespace chronos
             wrapee.handleNextTask();
         }
 
-        void reload(schedule_ptr_t new_schedule)
+        void handleDueTasks()
+        {
+            wrapee.handleDueTasks();
+        }
+
+        auto reload(const tasks_t &tasks)
+        {
+            const auto summary { wrapee.reload(tasks) };
+            logging::dispatcher::log_reload(summary);
+            return summary;
+        }
+
+        void setWakeUp(wake_up_t callback)
+        {
+            wrapee.setWakeUp(callback);
+        }
+
+        void setCapacity(std::size_t slots)
         {
-            wrapee.reload(new_schedule);
-            logging::dispatcher::log_reload();
+            wrapee.setCapacity(slots);
         }
 
     private:
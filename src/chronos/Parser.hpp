@@ -1,14 +1,22 @@
 #pragma once
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
-#include "boost/spirit/home/qi/string/symbols.hpp"
-#include "boost/fusion/include/adapt_struct.hpp"
-#include "boost/spirit/include/phoenix.hpp"
-#include "boost/spirit/include/qi.hpp"
+#include "fmt/core.h"
+#include "chronos/Cron.hpp"
+#include "chronos/Execution.hpp"
 
 
 namespace chronos::parser::literals
@@ -18,15 +26,36 @@ namespace chronos::parser::literals
     constexpr auto COLON { ':' };
     constexpr auto COMMA { '.' };
 
-    constexpr auto A { "a" };
-    constexpr auto AN { "an" };
-
-    constexpr auto RUN { "run" };
-    constexpr auto EVERY { "every" };
-    constexpr auto AT { "at" };
-    constexpr auto RETRY_AFTER { "retry after" };
-    constexpr auto TIME { "time" };
-    constexpr auto TIMES { "times" };
+    constexpr std::string_view A { "a" };
+    constexpr std::string_view AN { "an" };
+
+    constexpr std::string_view RUN { "run" };
+    constexpr std::string_view EVERY { "every" };
+    constexpr std::string_view CRON { "cron" };
+    constexpr std::string_view AT { "at" };
+    constexpr std::string_view RETRY { "retry" };
+    constexpr std::string_view AFTER { "after" };
+    constexpr std::string_view WITH { "with" };
+    constexpr std::string_view BACKOFF { "backoff" };
+    constexpr std::string_view UP { "up" };
+    constexpr std::string_view TO { "to" };
+    constexpr std::string_view TIME { "time" };
+    constexpr std::string_view TIMES { "times" };
+    constexpr std::string_view SPLAY { "splay" };
+    constexpr std::string_view CIRCUIT { "circuit" };
+    constexpr std::string_view FAILURE { "failure" };
+    constexpr std::string_view FAILURES { "failures" };
+    constexpr std::string_view FOR { "for" };
+    constexpr std::string_view TIMEOUT { "timeout" };
+    constexpr std::string_view CAPTURE { "capture" };
+    constexpr std::string_view PRIORITY { "priority" };
+    constexpr std::string_view GROUP { "group" };
+    constexpr std::string_view CONCURRENCY { "concurrency" };
+    constexpr std::string_view RATE { "rate" };
+    constexpr std::string_view PER { "per" };
+
+    // Splay count of entries without their own splay part
+    constexpr auto UNSPECIFIED_SPLAY { -1 };
 }
 
 namespace chronos::parser::enums
@@ -48,6 +77,21 @@ namespace chronos::parser::enums
         DAYS
     };
 
+    enum class OutputSize
+    {
+        BYTES,
+        KILOBYTES,
+        MEGABYTES
+    };
+
+    enum class TaskPriority
+    {
+        LOW,
+        NORMAL,
+        HIGH,
+        CRITICAL
+    };
+
     enum class WeekDay
     {
         MONDAY,
@@ -94,265 +138,959 @@ namespace chronos::parser::strct
 {
     using namespace enums;
 
+    /*
+     * Parts of an entry default to what an entry leaving them out means.
+     * Command and group name view the parsed input.
+     */
     struct TaskEntry
     {
         struct FrequencyPart
         {
-            int frequency_time_count;
-            TaskFrequency frequency_unit;
+            int frequency_time_count { 1 };
+            TaskFrequency frequency_unit { TaskFrequency::MINUTES };
         };
 
         struct AtPart
         {
-            using day_t = boost::variant<int, WeekDay>;
+            using day_t = std::variant<int, WeekDay>;
 
-            day_t day;
-            int hour;
-            int minute;
+            day_t day { 1 };
+            int hour { 0 };
+            int minute { 0 };
+        };
+
+        struct SplayPart
+        {
+            int splay_time_count { literals::UNSPECIFIED_SPLAY };
+            RetryTime splay_time_unit { RetryTime::SECONDS };
         };
 
         struct RetryPart
         {
-            int retry_time_count;
-            RetryTime retry_time_unit;
-            int retries_count;
+            int retry_time_count { 0 };
+            RetryTime retry_time_unit { RetryTime::SECONDS };
+            int backoff_limit_count { 0 };
+            RetryTime backoff_limit_unit { RetryTime::SECONDS };
+            int retries_count { 0 };
+        };
+
+        struct CircuitPart
+        {
+            int failures_count { 0 };
+            int cool_down_count { 0 };
+            RetryTime cool_down_unit { RetryTime::SECONDS };
+        };
+
+        struct TimeoutPart
+        {
+            int timeout_time_count { 0 };
+            RetryTime timeout_time_unit { RetryTime::SECONDS };
+        };
+
+        struct CapturePart
+        {
+            int capture_size_count { 0 };
+            OutputSize capture_size_unit { OutputSize::BYTES };
         };
 
-        std::string command;
+        struct GroupDefinition
+        {
+            struct RatePart
+            {
+                int starts_count { 0 };
+                RetryTime starts_time_unit { RetryTime::SECONDS };
+            };
+
+            std::string_view name;
+            int max_concurrent { 0 };
+            RatePart rate_part;
+        };
+
+        std::string_view command;
         FrequencyPart frequency_part;
         AtPart at_part;
+        // Set by a cron entry, which has no frequency and at parts
+        cron::Expression cron;
+        SplayPart splay_part;
         RetryPart retry_part;
+        CircuitPart circuit_part;
+        TimeoutPart timeout_part;
+        CapturePart capture_part;
+        TaskPriority priority { TaskPriority::NORMAL };
+        std::string_view group;
+        // Filled in from the group statement, not parsed with the entry
+        GroupDefinition group_definition;
     };
-}
 
+    using GroupDefinition = TaskEntry::GroupDefinition;
+}
 
-BOOST_FUSION_ADAPT_STRUCT(
-        chronos::parser::strct::TaskEntry::RetryPart,
-        (int, retry_time_count),
-        (chronos::parser::enums::RetryTime, retry_time_unit),
-        (int, retries_count))
+namespace chronos::parser::symbols
+{
+    using namespace enums;
 
-BOOST_FUSION_ADAPT_STRUCT(
-        chronos::parser::strct::TaskEntry::FrequencyPart,
-        (int, frequency_time_count),
-        (chronos::parser::enums::TaskFrequency, frequency_unit))
+    template <typename ValueT, std::size_t SIZE>
+    using table_t = std::array<std::pair<std::string_view, ValueT>, SIZE>;
+
+    constexpr table_t<TaskFrequency, 5> TASK_FREQUENCY_UNIT_PLURAL { {
+        { "minutes", TaskFrequency::MINUTES },
+        { "hours", TaskFrequency::HOURS },
+        { "days", TaskFrequency::DAYS },
+        { "weeks", TaskFrequency::WEEKS },
+        { "months", TaskFrequency::MONTHS } } };
+
+    constexpr table_t<TaskFrequency, 5> TASK_FREQUENCY_UNIT_SINGULAR { {
+        { "minute", TaskFrequency::MINUTES },
+        { "hour", TaskFrequency::HOURS },
+        { "day", TaskFrequency::DAYS },
+        { "week", TaskFrequency::WEEKS },
+        { "month", TaskFrequency::MONTHS } } };
+
+    constexpr table_t<RetryTime, 4> RETRY_FREQUENCY_UNIT_PLURAL { {
+        { "seconds", RetryTime::SECONDS },
+        { "minutes", RetryTime::MINUTES },
+        { "hours", RetryTime::HOURS },
+        { "days", RetryTime::DAYS } } };
+
+    constexpr table_t<RetryTime, 4> RETRY_FREQUENCY_UNIT_SINGULAR { {
+        { "second", RetryTime::SECONDS },
+        { "minute", RetryTime::MINUTES },
+        { "hour", RetryTime::HOURS },
+        { "day", RetryTime::DAYS } } };
+
+    constexpr table_t<OutputSize, 6> OUTPUT_SIZE_UNIT { {
+        { "bytes", OutputSize::BYTES },
+        { "byte", OutputSize::BYTES },
+        { "kilobytes", OutputSize::KILOBYTES },
+        { "kilobyte", OutputSize::KILOBYTES },
+        { "megabytes", OutputSize::MEGABYTES },
+        { "megabyte", OutputSize::MEGABYTES } } };
+
+    constexpr table_t<TaskPriority, 4> TASK_PRIORITY { {
+        { "low", TaskPriority::LOW },
+        { "normal", TaskPriority::NORMAL },
+        { "high", TaskPriority::HIGH },
+        { "critical", TaskPriority::CRITICAL } } };
+
+    constexpr table_t<WeekDay, 7> WEEK_DAY { {
+        { "monday", WeekDay::MONDAY },
+        { "tuesday", WeekDay::TUESDAY },
+        { "wednesday", WeekDay::WEDNESDAY },
+        { "thursday", WeekDay::THURSDAY },
+        { "friday", WeekDay::FRIDAY },
+        { "saturday", WeekDay::SATURDAY },
+        { "sunday", WeekDay::SUNDAY } } };
+
+    constexpr table_t<int, 12> CRON_MONTH { {
+        { "jan", 1 }, { "feb", 2 }, { "mar", 3 }, { "apr", 4 },
+        { "may", 5 }, { "jun", 6 }, { "jul", 7 }, { "aug", 8 },
+        { "sep", 9 }, { "oct", 10 }, { "nov", 11 }, { "dec", 12 } } };
+
+    constexpr table_t<int, 7> CRON_WEEK_DAY { {
+        { "sun", 0 }, { "mon", 1 }, { "tue", 2 }, { "wed", 3 },
+        { "thu", 4 }, { "fri", 5 }, { "sat", 6 } } };
+
+    constexpr table_t<int, 0> NO_NAMES { };
+}
 
-BOOST_FUSION_ADAPT_STRUCT(
-        chronos::parser::strct::TaskEntry::AtPart,
-        (chronos::parser::strct::TaskEntry::AtPart::day_t, day),
-        (int, hour),
-        (int, minute))
+namespace chronos::parser::error
+{
+    class SyntaxError : public std::runtime_error
+    {
+    public:
+        SyntaxError(std::size_t line, std::size_t column,
+                    const std::string &message)
+            : std::runtime_error(fmt::format(
+                    "Syntax error at line {}, column {}: {}",
+                    line, column, message)),
+            line_number(line),
+            column_number(column) { }
+
+        [[nodiscard]] std::size_t line() const
+        {
+            return line_number;
+        }
 
-BOOST_FUSION_ADAPT_STRUCT(
-        chronos::parser::strct::TaskEntry,
-        (std::string, command),
-        (chronos::parser::strct::TaskEntry::FrequencyPart, frequency_part),
-        (chronos::parser::strct::TaskEntry::AtPart, at_part)
-        (chronos::parser::strct::TaskEntry::RetryPart, retry_part))
+        [[nodiscard]] std::size_t column() const
+        {
+            return column_number;
+        }
 
+    private:
+        std::size_t line_number;
+        std::size_t column_number;
+    };
+}
 
-namespace chronos::parser::symbols
+namespace chronos::parser::detail
 {
-    using boost::spirit::qi::symbols;
+    constexpr bool is_space(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
 
-    using namespace enums;
+    constexpr bool is_digit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    constexpr bool is_alpha(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
 
-    struct task_frequency_unit_plural : symbols<char, TaskFrequency>
+    constexpr char to_lower(char c)
     {
-        task_frequency_unit_plural()
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // Keywords are spelled in lower case
+    constexpr bool equals_no_case(std::string_view word,
+                                  std::string_view keyword)
+    {
+        if (word.size() != keyword.size())
+            return false;
+        for (std::size_t i = 0; i < word.size(); ++i)
+            if (to_lower(word[i]) != keyword[i])
+                return false;
+        return true;
+    }
+
+    /*
+     * Reads tokens in place off the input, which it only views. A word
+     * is a run of letters and matches a keyword regardless of case. The
+     * position is turned into a line and a column only on an error.
+     */
+    class Scanner
+    {
+    public:
+        explicit Scanner(std::string_view input) : input(input) { }
+
+        // Reads [begin, end) of the input, reporting positions in all of it
+        Scanner(std::string_view input, std::size_t begin, std::size_t end)
+            : input(input.substr(0, end)), position(begin) { }
+
+        bool atEnd()
         {
-            add
-                ("minutes", TaskFrequency::MINUTES)
-                ("hours", TaskFrequency::HOURS)
-                ("days", TaskFrequency::DAYS)
-                ("weeks", TaskFrequency::WEEKS)
-                ("months", TaskFrequency::MONTHS);
+            return mark() == input.size();
         }
-    };
 
-    struct task_frequency_unit_singular : symbols<char, TaskFrequency>
-    {
-        task_frequency_unit_singular()
+        // Position of the next token
+        std::size_t mark()
         {
-            add
-                ("minute", TaskFrequency::MINUTES)
-                ("hour", TaskFrequency::HOURS)
-                ("day", TaskFrequency::DAYS)
-                ("week", TaskFrequency::WEEKS)
-                ("month", TaskFrequency::MONTHS);
+            while (position < input.size() && is_space(input[position]))
+                ++position;
+            return position;
         }
-    };
 
-    struct retry_frequency_unit_plural : symbols<char, RetryTime>
-    {
-        retry_frequency_unit_plural()
+        bool acceptKeyword(std::string_view keyword)
         {
-            add
-                ("seconds", RetryTime::SECONDS)
-                ("minutes", RetryTime::MINUTES)
-                ("hours", RetryTime::HOURS)
-                ("days", RetryTime::DAYS);
+            const auto word { peekWord() };
+            if (!equals_no_case(word, keyword))
+                return false;
+            position += word.size();
+            return true;
         }
-    };
 
-    struct retry_frequency_unit_singular : symbols<char, RetryTime>
-    {
-        retry_frequency_unit_singular()
+        void expectKeyword(std::string_view keyword)
+        {
+            if (!acceptKeyword(keyword))
+                fail(fmt::format("'{}'", keyword));
+        }
+
+        template <typename ValueT, std::size_t SIZE>
+        std::optional<ValueT>
+        acceptWord(const symbols::table_t<ValueT, SIZE> &table)
+        {
+            const auto word { peekWord() };
+            for (const auto &[name, value] : table)
+                if (equals_no_case(word, name)) {
+                    position += word.size();
+                    return value;
+                }
+            return std::nullopt;
+        }
+
+        template <typename ValueT, std::size_t SIZE>
+        ValueT expectWord(const symbols::table_t<ValueT, SIZE> &table,
+                          std::string_view expected)
+        {
+            const auto value { acceptWord(table) };
+            if (!value)
+                fail(expected);
+            return *value;
+        }
+
+        bool acceptChar(char c)
+        {
+            if (mark() == input.size() || input[position] != c)
+                return false;
+            ++position;
+            return true;
+        }
+
+        void expectChar(char c)
+        {
+            if (!acceptChar(c))
+                fail(fmt::format("'{}'", c));
+        }
+
+        bool peekNumber()
+        {
+            return mark() < input.size() && is_digit(input[position]);
+        }
+
+        std::optional<int> acceptNumber()
+        {
+            if (!peekNumber())
+                return std::nullopt;
+            const auto start { position };
+            std::int64_t value { 0 };
+            while (position < input.size() && is_digit(input[position])) {
+                value = value * 10 + (input[position++] - '0');
+                if (value > std::numeric_limits<int>::max())
+                    failAt(start, "a smaller number");
+            }
+            return static_cast<int>(value);
+        }
+
+        int expectNumber(int min, int max, std::string_view expected)
+        {
+            const auto start { mark() };
+            const auto number { acceptNumber() };
+            if (!number || *number < min || *number > max)
+                failAt(start, expected);
+            return *number;
+        }
+
+        // Text between quotes, which may not be empty
+        std::string_view expectQuoted(std::string_view expected)
+        {
+            const auto start { mark() };
+            if (!acceptChar(literals::QUOTE))
+                fail(expected);
+            const auto end { input.find(literals::QUOTE, position) };
+            if (end == std::string_view::npos || end == position)
+                failAt(start, expected);
+            const auto text { input.substr(position, end - position) };
+            position = end + 1;
+            return text;
+        }
+
+        [[noreturn]] void fail(std::string_view expected)
+        {
+            failAt(mark(), expected);
+        }
+
+        [[noreturn]] void failAt(std::size_t at,
+                                 std::string_view expected) const
+        {
+            const auto before { input.substr(0, at) };
+            const auto line {
+                std::count(begin(before), end(before), '\n') + 1 };
+            const auto line_start { before.rfind('\n') };
+            const auto column { line_start == std::string_view::npos
+                ? at + 1 : at - line_start };
+            throw error::SyntaxError(line, column, fmt::format(
+                    "expected {}, found {}", expected, describe(at)));
+        }
+
+    private:
+        // Optional parts peek at the same word in turn, so it is kept
+        std::string_view peekWord()
+        {
+            if (peeked_at == mark())
+                return peeked;
+            auto end { position };
+            while (end < input.size() && is_alpha(input[end]))
+                ++end;
+            peeked_at = position;
+            peeked = input.substr(position, end - position);
+            return peeked;
+        }
+
+        std::string describe(std::size_t at) const
         {
-            add
-                ("second", RetryTime::SECONDS)
-                ("minute", RetryTime::MINUTES)
-                ("hour", RetryTime::HOURS)
-                ("day", RetryTime::DAYS);
+            if (at == input.size())
+                return "end of input";
+            auto end { at + 1 };
+            while (end < input.size() && is_alpha(input[at])
+                   && is_alpha(input[end]))
+                ++end;
+            return fmt::format("'{}'", input.substr(at, end - at));
         }
+
+        std::string_view input;
+        std::size_t position { 0 };
+        std::size_t peeked_at { std::string_view::npos };
+        std::string_view peeked;
     };
+}
 
-    struct week_day : symbols<char, WeekDay>
+namespace chronos::parser::detail
+{
+    /*
+     * Reads the fields of a cron expression off the text of its quotes,
+     * which starts at the given position of the whole input, so mistakes
+     * are reported where they are. Fields are separated by spaces.
+     */
+    class CronReader
     {
-        week_day()
+    public:
+        CronReader(Scanner &scanner, std::string_view text,
+                   std::size_t text_at)
+            : scanner(scanner), text(text), text_at(text_at)
+        {
+            skipSpaces();
+        }
+
+        bool atStar() const
+        {
+            return position < text.size() && text[position] == '*';
+        }
+
+        // Bits of the values of a field, from the minimum to the maximum
+        template <std::size_t SIZE>
+        std::uint64_t field(int min, int max,
+                            const symbols::table_t<int, SIZE> &names)
+        {
+            if (position == text.size())
+                failHere("another cron field");
+            std::uint64_t bits { 0 };
+            do {
+                bits |= item(min, max, names);
+            } while (acceptChar(','));
+            if (position < text.size() && !is_space(text[position]))
+                failHere("',' or a space");
+            skipSpaces();
+            return bits;
+        }
+
+        void expectEnd()
+        {
+            if (position != text.size())
+                failHere("end of the cron expression");
+        }
+
+    private:
+        template <std::size_t SIZE>
+        std::uint64_t item(int min, int max,
+                           const symbols::table_t<int, SIZE> &names)
+        {
+            const auto start { position };
+            auto first { min };
+            auto last { max };
+            const auto star { acceptChar('*') };
+            if (!star) {
+                first = value(min, max, names);
+                last = acceptChar('-') ? value(min, max, names) : first;
+            }
+            auto step { 1 };
+            if (acceptChar('/')) {
+                step = value(1, max, symbols::NO_NAMES);
+                if (!star && last == first)
+                    last = max;
+            }
+            if (first > last)
+                scanner.failAt(text_at + start, "a range from low to high");
+            std::uint64_t bits { 0 };
+            for (auto value = first; value <= last; value += step)
+                bits |= std::uint64_t(1) << value;
+            return bits;
+        }
+
+        template <std::size_t SIZE>
+        int value(int min, int max, const symbols::table_t<int, SIZE> &names)
+        {
+            const auto start { position };
+            if (position < text.size() && is_digit(text[position])) {
+                auto number { 0 };
+                while (position < text.size() && is_digit(text[position])
+                       && number <= max)
+                    number = number * 10 + (text[position++] - '0');
+                if (number >= min && number <= max)
+                    return number;
+            } else {
+                while (position < text.size() && is_alpha(text[position]))
+                    ++position;
+                const auto word { text.substr(start, position - start) };
+                for (const auto &[name, value] : names)
+                    if (equals_no_case(word, name))
+                        return value;
+            }
+            scanner.failAt(text_at + start, fmt::format(
+                    "a value from {} to {}", min, max));
+        }
+
+        bool acceptChar(char c)
+        {
+            if (position == text.size() || text[position] != c)
+                return false;
+            ++position;
+            return true;
+        }
+
+        void skipSpaces()
+        {
+            while (position < text.size() && is_space(text[position]))
+                ++position;
+        }
+
+        [[noreturn]] void failHere(std::string_view expected)
         {
-            add
-                ("monday", WeekDay::MONDAY)
-                ("tuesday", WeekDay::TUESDAY)
-                ("wednesday", WeekDay::WEDNESDAY)
-                ("thursday", WeekDay::THURSDAY)
-                ("friday", WeekDay::FRIDAY)
-                ("saturday", WeekDay::SATURDAY)
-                ("sunday", WeekDay::SUNDAY);
+            scanner.failAt(text_at + position, expected);
         }
+
+        Scanner &scanner;
+        std::string_view text;
+        std::size_t text_at;
+        std::size_t position { 0 };
     };
 }
 
-namespace chronos::parser
+namespace chronos::parser::rules
 {
-    namespace qi = boost::spirit::qi;
-    namespace ascii = boost::spirit::ascii;
-
-    using namespace qi;
     using namespace enums;
     using namespace literals;
     using namespace strct;
     using namespace symbols;
+    using detail::Scanner;
+
+    constexpr std::string_view PLURAL_TIME_UNIT {
+        "seconds, minutes, hours or days" };
+    constexpr std::string_view SINGULAR_TIME_UNIT {
+        "a number or second, minute, hour or day" };
+
+    // Count with a plural unit, or a singular unit with an optional article
+    std::pair<int, RetryTime> time_span(Scanner &scanner)
+    {
+        if (const auto count { scanner.acceptNumber() })
+            return { *count, scanner.expectWord(
+                    RETRY_FREQUENCY_UNIT_PLURAL, PLURAL_TIME_UNIT) };
+        if (!scanner.acceptKeyword(AN))
+            scanner.acceptKeyword(A);
+        return { 1, scanner.expectWord(
+                RETRY_FREQUENCY_UNIT_SINGULAR, SINGULAR_TIME_UNIT) };
+    }
+
+    // Count with a unit in either number
+    std::pair<int, RetryTime> counted_time_span(Scanner &scanner)
+    {
+        const auto count { scanner.expectNumber(
+                0, std::numeric_limits<int>::max(), "a number") };
+        if (const auto unit { scanner.acceptWord(
+                RETRY_FREQUENCY_UNIT_PLURAL) })
+            return { count, *unit };
+        return { count, scanner.expectWord(
+                RETRY_FREQUENCY_UNIT_SINGULAR, PLURAL_TIME_UNIT) };
+    }
+
+    TaskEntry::FrequencyPart frequency(Scanner &scanner)
+    {
+        if (const auto count { scanner.acceptNumber() })
+            return { *count, scanner.expectWord(TASK_FREQUENCY_UNIT_PLURAL,
+                    "minutes, hours, days, weeks or months") };
+        return { 1, scanner.expectWord(TASK_FREQUENCY_UNIT_SINGULAR,
+                "a number or minute, hour, day, week or month") };
+    }
+
+    void day_time(Scanner &scanner, TaskEntry::AtPart &part)
+    {
+        part.hour = scanner.expectNumber(0, 24, "an hour");
+        if (!scanner.acceptChar(COLON) && !scanner.acceptChar(COMMA))
+            scanner.fail("':'");
+        part.minute = scanner.expectNumber(0, 59, "a minute");
+    }
+
+    /*
+     * A week day or a month day followed by time of day, time of day
+     * alone, or a minute alone.
+     */
+    TaskEntry::AtPart at(Scanner &scanner)
+    {
+        TaskEntry::AtPart part;
+        if (const auto week_day { scanner.acceptWord(WEEK_DAY) }) {
+            part.day = *week_day;
+            day_time(scanner, part);
+            return part;
+        }
+        const auto start { scanner.mark() };
+        const auto number { scanner.expectNumber(
+                0, std::numeric_limits<int>::max(),
+                "a day, an hour or a minute") };
+        part.day = 0;
+        if (scanner.acceptChar(COLON) || scanner.acceptChar(COMMA)) {
+            if (number > 24)
+                scanner.failAt(start, "an hour");
+            part.hour = number;
+            part.minute = scanner.expectNumber(0, 59, "a minute");
+        } else if (scanner.peekNumber()) {
+            if (number < 1 || number > 31)
+                scanner.failAt(start, "a day of the month");
+            part.day = number;
+            day_time(scanner, part);
+        } else {
+            if (number > 59)
+                scanner.failAt(start, "a minute");
+            part.minute = number;
+        }
+        return part;
+    }
+
+    TaskEntry::RetryPart retry(Scanner &scanner)
+    {
+        TaskEntry::RetryPart part;
+        if (scanner.acceptKeyword(AFTER)) {
+            std::tie(part.retry_time_count, part.retry_time_unit) =
+                    time_span(scanner);
+        } else {
+            if (!scanner.acceptKeyword(WITH))
+                scanner.fail("'after' or 'with backoff'");
+            scanner.expectKeyword(BACKOFF);
+            std::tie(part.retry_time_count, part.retry_time_unit) =
+                    counted_time_span(scanner);
+            scanner.expectKeyword(UP);
+            scanner.expectKeyword(TO);
+            std::tie(part.backoff_limit_count, part.backoff_limit_unit) =
+                    counted_time_span(scanner);
+        }
+        part.retries_count = 1;
+        if (const auto count { scanner.acceptNumber() }) {
+            part.retries_count = *count;
+            if (!scanner.acceptKeyword(TIMES) && !scanner.acceptKeyword(TIME))
+                scanner.fail("'times'");
+        }
+        return part;
+    }
+
+    // "after <n> failures for <time span>", following "circuit"
+    TaskEntry::CircuitPart circuit(Scanner &scanner)
+    {
+        TaskEntry::CircuitPart part;
+        scanner.expectKeyword(AFTER);
+        part.failures_count = scanner.expectNumber(
+                1, std::numeric_limits<int>::max(), "a positive number");
+        if (!scanner.acceptKeyword(FAILURES)
+                && !scanner.acceptKeyword(FAILURE))
+            scanner.fail("'failures'");
+        scanner.expectKeyword(FOR);
+        std::tie(part.cool_down_count, part.cool_down_unit) =
+                time_span(scanner);
+        return part;
+    }
+
+    /*
+     * Quoted cron expression of five fields: minute, hour, day of the
+     * month, month and day of the week. A field is a list of values,
+     * ranges or "*", each with an optional "/step". Months and days of
+     * the week may be named by their first three letters.
+     */
+    cron::Expression cron_expression(Scanner &scanner)
+    {
+        const auto quote_at { scanner.mark() };
+        const auto text { scanner.expectQuoted("a quoted cron expression") };
+        detail::CronReader reader(scanner, text, quote_at + 1);
+        const auto minutes { reader.field(0, 59, NO_NAMES) };
+        const auto hours { reader.field(0, 23, NO_NAMES) };
+        const auto month_days_restricted { !reader.atStar() };
+        const auto month_days { reader.field(1, 31, NO_NAMES) };
+        const auto months { reader.field(1, 12, CRON_MONTH) };
+        const auto week_days_restricted { !reader.atStar() };
+        const auto week_days { reader.field(0, 7, CRON_WEEK_DAY) };
+        reader.expectEnd();
+
+        cron::Expression expression;
+        expression.minutes = minutes;
+        expression.hours = hours;
+        expression.month_days = month_days;
+        expression.months = months;
+        // Sunday is both 0 and 7
+        expression.week_days = (week_days | week_days >> 7) & 0x7f;
+        expression.either_day = month_days_restricted && week_days_restricted;
+        if (!cron::detail::has_day(expression))
+            scanner.failAt(quote_at, "a cron expression with existing days");
+        return expression;
+    }
+
+    // The rest of an entry after its "run" keyword
+    TaskEntry entry(Scanner &scanner)
+    {
+        TaskEntry entry;
+        entry.command = scanner.expectQuoted("a quoted command");
+        if (scanner.acceptKeyword(CRON)) {
+            entry.cron = cron_expression(scanner);
+        } else {
+            if (!scanner.acceptKeyword(EVERY))
+                scanner.fail("'every' or 'cron'");
+            entry.frequency_part = frequency(scanner);
+            const auto at_start { scanner.mark() };
+            if (scanner.acceptKeyword(AT))
+                entry.at_part = at(scanner);
+            const auto unit { entry.frequency_part.frequency_unit };
+            if (unit == TaskFrequency::WEEKS
+                    && !std::holds_alternative<WeekDay>(entry.at_part.day))
+                scanner.failAt(at_start, "'at' with a day of the week");
+            if (unit == TaskFrequency::MONTHS
+                    && !std::holds_alternative<int>(entry.at_part.day))
+                scanner.failAt(at_start, "'at' with a day of the month");
+        }
+        if (scanner.acceptKeyword(SPLAY))
+            std::tie(entry.splay_part.splay_time_count,
+                     entry.splay_part.splay_time_unit) = time_span(scanner);
+        if (scanner.acceptKeyword(RETRY))
+            entry.retry_part = retry(scanner);
+        if (scanner.acceptKeyword(CIRCUIT))
+            entry.circuit_part = circuit(scanner);
+        if (scanner.acceptKeyword(TIMEOUT))
+            std::tie(entry.timeout_part.timeout_time_count,
+                     entry.timeout_part.timeout_time_unit) =
+                    time_span(scanner);
+        if (scanner.acceptKeyword(CAPTURE)) {
+            entry.capture_part.capture_size_count = scanner.expectNumber(
+                    1, std::numeric_limits<int>::max(), "a positive number");
+            entry.capture_part.capture_size_unit = scanner.expectWord(
+                    OUTPUT_SIZE_UNIT, "bytes, kilobytes or megabytes");
+        }
+        if (scanner.acceptKeyword(PRIORITY))
+            entry.priority = scanner.expectWord(
+                    TASK_PRIORITY, "low, normal, high or critical");
+        if (scanner.acceptKeyword(GROUP))
+            entry.group = scanner.expectQuoted("a quoted group name");
+        scanner.expectChar(ENDL);
+        return entry;
+    }
 
-    using iterator_t = std::string::const_iterator;
-    using token_t = std::string;
-    using space_t = ascii::space_type;
-
-    using boost::spirit::ascii::no_case;
-
-    struct parser : grammar<iterator_t, TaskEntry(), space_t>
-    {
-        using task_entry_rule = rule<iterator_t, TaskEntry(), space_t>;
-        using retry_part_rule =
-                rule<iterator_t, TaskEntry::RetryPart(), space_t>;
-        using retry_times_rule = rule<iterator_t, int, space_t>;
-        using frequency_rule =
-                rule<iterator_t, TaskEntry::FrequencyPart(), space_t>;
-        using at_part_rule = rule<iterator_t, TaskEntry::AtPart(), space_t>;
-
-        rule<iterator_t, std::string(), space_t> article;
-        rule<iterator_t, std::string(), space_t> time_s;
-        rule<iterator_t, std::string(), space_t> command;
-        frequency_rule frequency_plural;
-        frequency_rule frequency_singular;
-        rule<iterator_t, int, space_t> minute;
-        rule<iterator_t, int, space_t> hour;
-        rule<iterator_t, int, space_t> month_day;
-        at_part_rule at_day;
-        at_part_rule at_hour;
-        at_part_rule at_minute;
-        at_part_rule at;
-        at_part_rule at_placeholder;
-        retry_part_rule retry;
-        retry_part_rule retry_plural;
-        retry_part_rule retry_singular;
-        retry_part_rule retry_placeholder;
-        retry_times_rule retry_times;
-        retry_times_rule retry_times_placeholder;
-        task_entry_rule start;
-        task_frequency_unit_plural task_frequency_unit_plural_;
-        task_frequency_unit_singular task_frequency_unit_singular_;
-        retry_frequency_unit_plural retry_frequency_unit_plural_;
-        retry_frequency_unit_singular retry_frequency_unit_singular_;
-        week_day week_day_;
-
-        parser() : parser::base_type(start)
-        {
-            article %= no_case[lit(AN)] | no_case[lit(A)];
-
-            time_s %= no_case[lit(TIMES)] | no_case[lit(TIME)];
-
-            command %= lexeme[QUOTE >> +(char_ - QUOTE) >> QUOTE];
-
-            frequency_plural %= uint_ >> no_case[task_frequency_unit_plural_];
-
-            frequency_singular %=
-                    attr(1)
-                    >> no_case[task_frequency_unit_singular_];
-
-            minute %= uint_ [_pass = (_1 >= 0 && _1 < 60)];
-
-            hour %= uint_ [_pass = (_1 >= 0 && _1 < 25)];
-
-            month_day %= uint_ [_pass = (_1 > 0 && _1 < 32)];
-
-            at %=
-                    no_case[lit(AT)]
-                    >> (at_day | at_hour | at_minute);
-
-            at_day %=
-                    (month_day | no_case[week_day_])
-                    >> hour
-                    >> (omit[COLON] | omit[COMMA])
-                    >> minute;
-
-            at_hour %=
-                    attr(0)
-                    >> hour
-                    >> (omit[COLON] | omit[COMMA])
-                    >> minute;
-
-            at_minute %=
-                    attr(0)
-                    >> attr(0)
-                    >> minute;
-
-            at_placeholder %= attr(1) >> attr(0) >> attr(0);
-
-            retry_times %= uint_ >> time_s;
-
-            retry_times_placeholder %= attr(1);
-
-            retry_plural %=
-                    uint_
-                    >> no_case[retry_frequency_unit_plural_]
-                    >> (retry_times | retry_times_placeholder);
-
-            retry_singular %=
-                    attr(1)
-                    >> omit[-article]
-                    >> no_case[retry_frequency_unit_singular_]
-                    >> (retry_times | retry_times_placeholder);
-
-            retry %=
-                    no_case[lit(RETRY_AFTER)]
-                    >> (retry_plural | retry_singular);
-
-            retry_placeholder %=
-                    attr(0)
-                    >> attr(RetryTime::SECONDS)
-                    >> attr(0);
-
-            start %=
-                    no_case[lit(RUN)]
-                    >> command
-                    >> no_case[lit(EVERY)]
-                    >> (frequency_plural | frequency_singular)
-                    >> (at | at_placeholder)
-                    >> (retry | retry_placeholder)
-                    >> ENDL;
+    // The rest of a splay statement after its "splay" keyword
+    TaskEntry::SplayPart splay_directive(Scanner &scanner)
+    {
+        TaskEntry::SplayPart part;
+        std::tie(part.splay_time_count, part.splay_time_unit) =
+                time_span(scanner);
+        scanner.expectChar(ENDL);
+        return part;
+    }
+
+    // The rest of a group statement after its "group" keyword
+    GroupDefinition group_definition(Scanner &scanner)
+    {
+        GroupDefinition group;
+        group.name = scanner.expectQuoted("a quoted group name");
+        if (scanner.acceptKeyword(CONCURRENCY))
+            group.max_concurrent = scanner.expectNumber(
+                    1, std::numeric_limits<int>::max(), "a positive number");
+        if (scanner.acceptKeyword(RATE)) {
+            group.rate_part.starts_count = scanner.expectNumber(
+                    1, std::numeric_limits<int>::max(), "a positive number");
+            scanner.expectKeyword(PER);
+            group.rate_part.starts_time_unit = scanner.expectWord(
+                    RETRY_FREQUENCY_UNIT_SINGULAR,
+                    "second, minute, hour or day");
         }
+        scanner.expectChar(ENDL);
+        return group;
+    }
+}
+
+namespace chronos::parser::detail
+{
+    // Smaller inputs are not worth starting threads for
+    constexpr std::size_t MIN_CHUNK_SIZE { 1 << 20 };
+
+    /*
+     * Statements of one chunk of a schedule. Entries without a splay of
+     * their own which come before the first splay statement of the chunk
+     * keep it unspecified until the chunks before it are parsed.
+     */
+    struct Chunk
+    {
+        std::vector<strct::TaskEntry> entries;
+        std::size_t leading_count { 0 };
+        std::optional<strct::TaskEntry::SplayPart> last_splay;
+        std::vector<strct::GroupDefinition> groups;
     };
+
+    std::size_t chunks_count_for(std::size_t input_size)
+    {
+        const std::size_t cores { std::max(
+                std::thread::hardware_concurrency(), 1u) };
+        return std::clamp<std::size_t>(input_size / MIN_CHUNK_SIZE, 1, cores);
+    }
+
+    /*
+     * Runs jobs numbered from 0 to count - 1, each on a worker of its own,
+     * and rethrows the error of the first failed one in that order.
+     */
+    template <typename JobT>
+    void run_in_parallel(std::size_t count, const JobT &job)
+    {
+        if (count == 1) {
+            job(0);
+            return;
+        }
+        std::vector<std::exception_ptr> errors(count);
+        {
+            execution::WorkerPool pool(count);
+            for (std::size_t i = 0; i < count; ++i)
+                pool.submit([&job, &errors, i] () {
+                    try {
+                        job(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                });
+        }
+        for (const auto &error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    /*
+     * Splits the input into about count chunks, each one ending right
+     * after a terminator outside a quoted text. Whether a quote is open
+     * where a chunk would start is known from the quotes before it.
+     */
+    std::vector<std::size_t> chunk_bounds(std::string_view input,
+                                          std::size_t count)
+    {
+        const auto raw_bound { [&input, count] (std::size_t i) {
+            return input.size() * i / count; } };
+        std::vector<std::size_t> quotes(count);
+        run_in_parallel(count, [&] (std::size_t i) {
+            quotes[i] = std::count(begin(input) + raw_bound(i),
+                                   begin(input) + raw_bound(i + 1),
+                                   literals::QUOTE);
+        });
+
+        std::vector<std::size_t> bounds { 0 };
+        std::size_t quotes_before { 0 };
+        for (std::size_t i = 1; i < count; ++i) {
+            quotes_before += quotes[i - 1];
+            auto quoted { quotes_before % 2 == 1 };
+            auto position { raw_bound(i) };
+            while (position < input.size()
+                   && (quoted || input[position] != literals::ENDL)) {
+                if (input[position] == literals::QUOTE)
+                    quoted = !quoted;
+                ++position;
+            }
+            const auto bound { position + 1 };
+            if (bound > bounds.back() && bound < input.size())
+                bounds.push_back(bound);
+        }
+        bounds.push_back(input.size());
+        return bounds;
+    }
+
+    Chunk parse_chunk(std::string_view input,
+                      std::size_t begin, std::size_t end)
+    {
+        Scanner scanner(input, begin, end);
+        Chunk chunk;
+        chunk.entries.reserve(std::count(input.begin() + begin,
+                                         input.begin() + end,
+                                         literals::ENDL));
+
+        while (!scanner.atEnd()) {
+            if (scanner.acceptKeyword(literals::RUN)) {
+                chunk.entries.push_back(rules::entry(scanner));
+                auto &splay { chunk.entries.back().splay_part };
+                if (!chunk.last_splay)
+                    ++chunk.leading_count;
+                else if (splay.splay_time_count == literals::UNSPECIFIED_SPLAY)
+                    splay = *chunk.last_splay;
+            } else if (scanner.acceptKeyword(literals::SPLAY)) {
+                chunk.last_splay = rules::splay_directive(scanner);
+            } else if (scanner.acceptKeyword(literals::GROUP)) {
+                chunk.groups.push_back(rules::group_definition(scanner));
+            } else {
+                scanner.fail("'run', 'splay' or 'group'");
+            }
+        }
+        return chunk;
+    }
+
+    // Carries splay statements across chunks and attaches group limits
+    void resolve(std::vector<Chunk> &chunks)
+    {
+        strct::TaskEntry::SplayPart default_splay {
+            0, enums::RetryTime::SECONDS };
+        std::unordered_map<std::string_view, strct::GroupDefinition> groups;
+        for (auto &chunk : chunks) {
+            for (std::size_t i = 0; i < chunk.leading_count; ++i) {
+                auto &splay { chunk.entries[i].splay_part };
+                if (splay.splay_time_count == literals::UNSPECIFIED_SPLAY)
+                    splay = default_splay;
+            }
+            default_splay = chunk.last_splay.value_or(default_splay);
+            for (const auto &group : chunk.groups)
+                groups[group.name] = group;
+        }
+
+        if (!groups.empty())
+            for (auto &chunk : chunks)
+                for (auto &entry : chunk.entries) {
+                    const auto group { groups.find(entry.group) };
+                    if (group != groups.end())
+                        entry.group_definition = group->second;
+                }
+    }
+}
+
+namespace chronos::parser
+{
+    /*
+     * Parses a schedule in chunks split at terminators outside quoted
+     * commands, one chunk per worker, and returns them in input order. A
+     * standalone "splay ...;" statement sets the splay of the entries
+     * after it which do not have one of their own. A "group ...;"
+     * statement defines limits of a group wherever it appears; a group
+     * without one has no limits. Entries view the input, which must
+     * outlive them.
+     */
+    std::vector<detail::Chunk> parse_chunks(std::string_view input,
+                                            std::size_t chunks_count)
+    {
+        const auto bounds { detail::chunk_bounds(input, chunks_count) };
+        std::vector<detail::Chunk> chunks(bounds.size() - 1);
+        try {
+            detail::run_in_parallel(chunks.size(), [&] (std::size_t i) {
+                chunks[i] = detail::parse_chunk(input, bounds[i],
+                                                bounds[i + 1]);
+            });
+        } catch (const error::SyntaxError &) {
+            if (chunks.size() == 1)
+                throw;
+            // A chunk may end inside a malformed statement, so the error
+            // is reported from a pass over the whole input
+            chunks.assign(1, detail::parse_chunk(input, 0, input.size()));
+        }
+        detail::resolve(chunks);
+        return chunks;
+    }
+
+    std::vector<detail::Chunk> parse_chunks(std::string_view input)
+    {
+        return parse_chunks(input, detail::chunks_count_for(input.size()));
+    }
+
+    std::vector<strct::TaskEntry> parse_entries(std::string_view input,
+                                                std::size_t chunks_count)
+    {
+        auto chunks { parse_chunks(input, chunks_count) };
+        if (chunks.size() == 1)
+            return std::move(chunks.front().entries);
+        std::vector<strct::TaskEntry> entries;
+        for (auto &chunk : chunks)
+            entries.insert(end(entries),
+                           std::make_move_iterator(begin(chunk.entries)),
+                           std::make_move_iterator(end(chunk.entries)));
+        return entries;
+    }
+
+    std::vector<strct::TaskEntry> parse_entries(std::string_view input)
+    {
+        return parse_entries(input, detail::chunks_count_for(input.size()));
+    }
 }
 
 namespace chronos::parser::conversions
@@ -377,13 +1115,31 @@ namespace chronos::parser::conversions
         return count * SECONDS_IN_DAY;
     }
 
+    std::uint64_t to_bytes(const OutputSize &unit, int count)
+    {
+        constexpr std::uint64_t BYTES_IN_KILOBYTE { 1024 };
+        constexpr std::uint64_t BYTES_IN_MEGABYTE { 1024 * 1024 };
+        std::uint64_t bytes { static_cast<std::uint64_t>(count) };
+        switch (unit)
+        {
+            case OutputSize::BYTES:
+                break;
+            case OutputSize::KILOBYTES:
+                bytes *= BYTES_IN_KILOBYTE;
+                break;
+            case OutputSize::MEGABYTES:
+                bytes *= BYTES_IN_MEGABYTE;
+                break;
+        }
+        return bytes;
+    }
+
     int to_seconds(const RetryTime &unit, int count)
     {
-        int seconds;
+        int seconds { count };
         switch (unit)
         {
             case RetryTime::SECONDS:
-                seconds = count;
                 break;
             case RetryTime::MINUTES:
                 seconds = minutes_to_seconds(count);
@@ -411,8 +1167,17 @@ namespace chronos::parser
                 .createTask()
                 .withCommand(output.command);
 
-            convertExecutionInfo(output);
+            if (cron::is_set(output.cron))
+                task_builder.onCron(output.cron);
+            else
+                convertExecutionInfo(output);
             convertRetryInfo(output);
+            convertCircuitInfo(output);
+            convertSplayInfo(output);
+            convertTimeoutInfo(output);
+            convertCaptureInfo(output);
+            convertPriorityInfo(output);
+            convertGroupInfo(output);
 
             return task_builder.build();
         }
@@ -451,10 +1216,77 @@ namespace chronos::parser
             const auto retry_time_unit { retry_info.retry_time_unit };
             const auto retry_after_seconds {
                 conversions::to_seconds(retry_time_unit, retry_time_count) };
+            const auto backoff_limit_seconds { conversions::to_seconds(
+                    retry_info.backoff_limit_unit,
+                    retry_info.backoff_limit_count) };
 
             task_builder
                 .retryTimes(retries_count)
-                .retryAfter(retry_after_seconds);
+                .retryAfter(retry_after_seconds)
+                .backoffUpTo(backoff_limit_seconds);
+        }
+
+        void convertCircuitInfo(const strct::TaskEntry &parser_output)
+        {
+            const auto circuit_info { parser_output.circuit_part };
+            const auto cool_down_seconds { conversions::to_seconds(
+                    circuit_info.cool_down_unit,
+                    circuit_info.cool_down_count) };
+            task_builder.breakCircuitAfter(circuit_info.failures_count,
+                                           cool_down_seconds);
+        }
+
+        void convertSplayInfo(const strct::TaskEntry &parser_output)
+        {
+            const auto splay_info { parser_output.splay_part };
+            if (splay_info.splay_time_count <= 0)
+                return;
+            const auto splay_seconds { conversions::to_seconds(
+                    splay_info.splay_time_unit,
+                    splay_info.splay_time_count) };
+            task_builder.splayWithin(splay_seconds);
+        }
+
+        void convertTimeoutInfo(const strct::TaskEntry &parser_output)
+        {
+            const auto timeout_info { parser_output.timeout_part };
+            const auto timeout_seconds { conversions::to_seconds(
+                    timeout_info.timeout_time_unit,
+                    timeout_info.timeout_time_count) };
+            task_builder.timeoutAfter(timeout_seconds);
+        }
+
+        void convertCaptureInfo(const strct::TaskEntry &parser_output)
+        {
+            const auto capture_info { parser_output.capture_part };
+            if (!capture_info.capture_size_count)
+                return;
+            const auto bytes { conversions::to_bytes(
+                    capture_info.capture_size_unit,
+                    capture_info.capture_size_count) };
+            constexpr std::uint64_t MAX_BYTES {
+                std::numeric_limits<std::uint32_t>::max() };
+            task_builder.captureBytes(std::min(bytes, MAX_BYTES));
+        }
+
+        void convertPriorityInfo(const strct::TaskEntry &parser_output)
+        {
+            const auto level { static_cast<int>(parser_output.priority) };
+            task_builder.withPriority(level);
+        }
+
+        void convertGroupInfo(const strct::TaskEntry &parser_output)
+        {
+            if (parser_output.group.empty())
+                return;
+            const auto definition { parser_output.group_definition };
+            const auto rate { definition.rate_part };
+            const auto starts_per_second { rate.starts_count
+                / static_cast<double>(
+                        conversions::to_seconds(rate.starts_time_unit, 1)) };
+            task_builder.inGroup(parser_output.group,
+                                 definition.max_concurrent,
+                                 starts_per_second);
         }
 
         void setTimeForMinutesFrequency(const strct::TaskEntry &parser_output)
@@ -491,11 +1323,11 @@ namespace chronos::parser
             const auto frequency { parser_output.frequency_part };
             const auto frequency_count { frequency.frequency_time_count };
             const auto at { parser_output.at_part };
-            const auto week_day { boost::get<WeekDay>(at.day) };
+            const auto week_day { std::get<enums::WeekDay>(at.day) };
             task_builder
                 .everyWeeksCount(frequency_count)
                 .atWeekDay(
-                    { .day = week_day_to_number(week_day),
+                    { .day = enums::week_day_to_number(week_day),
                       .hour = at.hour, .minute = at.minute });
         }
 
@@ -504,7 +1336,7 @@ namespace chronos::parser
             const auto frequency { parser_output.frequency_part };
             const auto frequency_count { frequency.frequency_time_count };
             const auto at { parser_output.at_part };
-            const auto month_day { boost::get<int>(at.day) };
+            const auto month_day { std::get<int>(at.day) };
             task_builder
                 .everyMonthsCount(frequency_count)
                 .atMonthDay(
@@ -516,62 +1348,33 @@ namespace chronos::parser
     };
 }
 
-namespace chronos::parser::error
-{
-    class SyntaxError : public std::runtime_error
-    {
-    public:
-        explicit SyntaxError(const std::string &bad_entry)
-            : std::runtime_error(bad_entry) { }
-    };
-}
-
-namespace chronos::parser
-{
-    void throw_parsing_error(const std::string::const_iterator &iter)
-    {
-        std::string bad_part { *iter };
-        throw error::SyntaxError("Syntax error at: " + bad_part);
-    }
-}
-
 namespace chronos
 {
     template <typename TaskBuilderT>
     class Parser
     {
     public:
-        using parsing_output_t = std::vector<parser::strct::TaskEntry>;
         using result_t = std::vector<typename TaskBuilderT::task_t>;
+        using clock_t = typename TaskBuilderT::clock_t;
 
-        result_t parse(const std::string &input)
+        // Chunks are converted on the workers which parsed them
+        result_t parse(std::string_view input)
         {
-            const auto parsing_output { parseToStruct(input) };
-            result_t result;
-            parser::Converter<TaskBuilderT> converter;
-            std::transform(begin(parsing_output), end(parsing_output),
-                           std::back_inserter(result),
-                           [&converter] (const auto &elem) {
-                                return converter.convert(elem); });
+            const auto chunks { parser::parse_chunks(input) };
+            std::vector<std::size_t> offsets { 0 };
+            for (const auto &chunk : chunks)
+                offsets.push_back(offsets.back() + chunk.entries.size());
+            result_t result(offsets.back());
+            parser::detail::run_in_parallel(chunks.size(),
+                                            [&] (std::size_t i) {
+                parser::Converter<TaskBuilderT> converter;
+                std::transform(begin(chunks[i].entries),
+                               end(chunks[i].entries),
+                               begin(result) + offsets[i],
+                               [&converter] (const auto &entry) {
+                                   return converter.convert(entry); });
+            });
             return result;
         }
-
-    private:
-        parsing_output_t parseToStruct(const std::string &input)
-        {
-            using boost::spirit::ascii::space;
-
-            std::vector<parser::strct::TaskEntry> output;
-            std::string::const_iterator iter(input.begin());
-            std::string::const_iterator end(input.end());
-
-            while (iter != end)
-                if(!phrase_parse(iter, end, parser, space, output))
-                    parser::throw_parsing_error(iter);
-
-            return output;
-        }
-
-        parser::parser parser;
     };
 }
@@ -0,0 +1,357 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "chronos/System.hpp"
+
+
+namespace chronos::system::error
+{
+    class ReactorSetupFailed : public std::runtime_error
+    {
+    public:
+        ReactorSetupFailed()
+            : std::runtime_error("Reactor setup failed") { }
+    };
+}
+
+namespace chronos::system::reactor::detail
+{
+    static constexpr int NO_DESCRIPTOR { -1 };
+
+    void set_non_blocking(int descriptor)
+    {
+        const auto flags { fcntl(descriptor, F_GETFL) };
+        fcntl(descriptor, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    int open_pidfd(pid_t pid)
+    {
+#ifdef SYS_pidfd_open
+        return syscall(SYS_pidfd_open, pid, 0);
+#else
+        return NO_DESCRIPTOR;
+#endif
+    }
+
+    void arm_timer(int timer, std::chrono::nanoseconds delay)
+    {
+        using namespace std::chrono;
+        itimerspec expiration {};
+        expiration.it_value.tv_sec = duration_cast<seconds>(delay).count();
+        expiration.it_value.tv_nsec = (delay % seconds(1)).count();
+        timerfd_settime(timer, 0, &expiration, nullptr);
+    }
+
+    int open_timer(std::chrono::nanoseconds delay)
+    {
+        const auto timer { timerfd_create(CLOCK_MONOTONIC,
+                                          TFD_CLOEXEC | TFD_NONBLOCK) };
+        arm_timer(timer, delay);
+        return timer;
+    }
+
+    void clear_timer(int timer)
+    {
+        std::uint64_t expirations;
+        [[maybe_unused]] const auto read_count {
+            read(timer, &expirations, sizeof(expirations)) };
+    }
+
+    void close_descriptor(int &descriptor)
+    {
+        if (descriptor != NO_DESCRIPTOR)
+            close(descriptor);
+        descriptor = NO_DESCRIPTOR;
+    }
+}
+
+namespace chronos::system::reactor
+{
+    using callback_t = std::function<void(const system::Response&)>;
+
+    /*
+     * Single thread supervising all running children. Output pipes and
+     * pidfds of the children sit in one epoll set; output is read in
+     * large chunks as it arrives and a child is reaped once its pidfd
+     * reports the exit. Without pidfd support the exit is polled for once
+     * the output reaches end of file, on a timer with growing pauses so
+     * that the other children are not held up. A child with a timeout
+     * also has a timer in the set; when it expires the process group of
+     * the child gets SIGTERM and, after a grace period, SIGKILL.
+     */
+    class Reactor
+    {
+    public:
+        Reactor()
+            : epoll(epoll_create1(EPOLL_CLOEXEC)),
+            wake_up(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        {
+            if (epoll < 0 || wake_up < 0)
+                throw error::ReactorSetupFailed();
+            watch(wake_up, WAKE_UP_KEY);
+            thread = std::thread([this] () { loop(); });
+        }
+
+        ~Reactor()
+        {
+            stopping = true;
+            signalWakeUp();
+            thread.join();
+            detail::close_descriptor(wake_up);
+            detail::close_descriptor(epoll);
+        }
+
+        void supervise(pid_t pid, int output, std::size_t output_limit,
+                       std::chrono::seconds timeout, callback_t callback)
+        {
+            detail::set_non_blocking(output);
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto id { ++last_id };
+            auto &child { children[id] };
+            child.pid = pid;
+            child.output = output;
+            child.pidfd = detail::open_pidfd(pid);
+            child.captured = capture::OutputBuffer(output_limit);
+            child.callback = std::move(callback);
+            watch(child.output, id << KIND_BITS | OUTPUT_KIND);
+            if (child.pidfd != detail::NO_DESCRIPTOR)
+                watch(child.pidfd, id << KIND_BITS | EXIT_KIND);
+            if (timeout.count()) {
+                child.timer = detail::open_timer(timeout);
+                watch(child.timer, id << KIND_BITS | DEADLINE_KIND);
+            }
+        }
+
+    private:
+        struct Child
+        {
+            pid_t pid;
+            int output { detail::NO_DESCRIPTOR };
+            int pidfd { detail::NO_DESCRIPTOR };
+            int timer { detail::NO_DESCRIPTOR };
+            int reap_timer { detail::NO_DESCRIPTOR };
+            std::chrono::milliseconds reap_pause { 1 };
+            std::optional<bool> success;
+            bool timed_out { false };
+            capture::OutputBuffer captured;
+            callback_t callback;
+        };
+
+        using key_t = std::uint64_t;
+
+        static constexpr key_t WAKE_UP_KEY { 0 };
+        static constexpr key_t KIND_BITS { 2 };
+        static constexpr key_t KIND_MASK { (1 << KIND_BITS) - 1 };
+        static constexpr key_t OUTPUT_KIND { 0 };
+        static constexpr key_t EXIT_KIND { 1 };
+        static constexpr key_t DEADLINE_KIND { 2 };
+        static constexpr key_t REAP_KIND { 3 };
+        static constexpr int MAX_EVENTS { 256 };
+        static constexpr std::size_t READ_CHUNK_SIZE { 64 * 1024 };
+
+        void watch(int descriptor, key_t key)
+        {
+            epoll_event event {};
+            event.events = EPOLLIN;
+            event.data.u64 = key;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, descriptor, &event);
+        }
+
+        void unwatch(int descriptor)
+        {
+            epoll_ctl(epoll, EPOLL_CTL_DEL, descriptor, nullptr);
+        }
+
+        void signalWakeUp()
+        {
+            const std::uint64_t increment { 1 };
+            [[maybe_unused]] const auto written {
+                write(wake_up, &increment, sizeof(increment)) };
+        }
+
+        bool finished()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return stopping && children.empty();
+        }
+
+        void loop()
+        {
+            std::array<epoll_event, MAX_EVENTS> events;
+            while (!finished()) {
+                const auto count { epoll_wait(epoll, events.data(),
+                                              MAX_EVENTS, -1) };
+                for (int i = 0; i < count; ++i)
+                    handle(events[i].data.u64);
+            }
+        }
+
+        void handle(key_t key)
+        {
+            if (key == WAKE_UP_KEY) {
+                std::uint64_t value;
+                [[maybe_unused]] const auto read_count {
+                    read(wake_up, &value, sizeof(value)) };
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            const auto child { children.find(key >> KIND_BITS) };
+            if (child == children.end())
+                return;
+            const auto kind { key & KIND_MASK };
+            if (kind == DEADLINE_KIND) {
+                expire(child->second);
+                return;
+            }
+            auto exited { kind == EXIT_KIND };
+            if (kind == REAP_KIND
+                    || (kind == OUTPUT_KIND && !drain(child->second)))
+                exited = pollExit(child->first, child->second);
+            if (!exited)
+                return;
+            auto finished_child { std::move(child->second) };
+            children.erase(child);
+            lock.unlock();
+            reap(finished_child);
+        }
+
+        // Reads available output, returns false once it reached the end
+        bool drain(Child &child)
+        {
+            std::array<char, READ_CHUNK_SIZE> buffer;
+            while (child.output != detail::NO_DESCRIPTOR) {
+                const auto count { read(child.output, buffer.data(),
+                                        buffer.size()) };
+                if (count > 0) {
+                    child.captured.append(buffer.data(), count);
+                } else if (!count) {
+                    closeOutput(child);
+                    return child.pidfd != detail::NO_DESCRIPTOR;
+                } else {
+                    return errno == EAGAIN || errno == EINTR;
+                }
+            }
+            return true;
+        }
+
+        // Reaps an exited child, or polls for its exit again a bit later
+        bool pollExit(key_t id, Child &child)
+        {
+            if (child.reap_timer != detail::NO_DESCRIPTOR)
+                detail::clear_timer(child.reap_timer);
+            child.success = spawn::try_reap(child.pid);
+            if (child.success)
+                return true;
+            if (child.reap_timer == detail::NO_DESCRIPTOR) {
+                child.reap_timer = detail::open_timer(child.reap_pause);
+                watch(child.reap_timer, id << KIND_BITS | REAP_KIND);
+            } else {
+                detail::arm_timer(child.reap_timer, child.reap_pause);
+            }
+            child.reap_pause = std::min(child.reap_pause * 2,
+                                        spawn::MAX_EXIT_POLL_INTERVAL);
+            return false;
+        }
+
+        void expire(Child &child)
+        {
+            detail::clear_timer(child.timer);
+            if (child.timed_out) {
+                spawn::signal_group(child.pid, SIGKILL);
+                return;
+            }
+            child.timed_out = true;
+            spawn::signal_group(child.pid, SIGTERM);
+            detail::arm_timer(child.timer, spawn::TERMINATION_GRACE_PERIOD);
+        }
+
+        void closeOutput(Child &child)
+        {
+            unwatch(child.output);
+            detail::close_descriptor(child.output);
+        }
+
+        void reap(Child &child)
+        {
+            drain(child);
+            if (child.output != detail::NO_DESCRIPTOR)
+                closeOutput(child);
+            if (child.pidfd != detail::NO_DESCRIPTOR) {
+                unwatch(child.pidfd);
+                detail::close_descriptor(child.pidfd);
+            }
+            if (child.timer != detail::NO_DESCRIPTOR) {
+                unwatch(child.timer);
+                detail::close_descriptor(child.timer);
+            }
+            if (child.reap_timer != detail::NO_DESCRIPTOR) {
+                unwatch(child.reap_timer);
+                detail::close_descriptor(child.reap_timer);
+            }
+            // Only a child whose pidfd reported the exit is left to reap
+            const auto success { child.success
+                ? *child.success : spawn::wait_for_success(child.pid) };
+            child.callback(make_response(success, child.captured,
+                                         child.timed_out));
+        }
+
+        int epoll;
+        int wake_up;
+        std::mutex mutex;
+        std::unordered_map<key_t, Child> children;
+        key_t last_id { 0 };
+        std::atomic<bool> stopping { false };
+        std::thread thread;
+    };
+}
+
+namespace chronos
+{
+    /*
+     * Asynchronous execution spawning commands and handing their output
+     * and exit over to a reactor thread.
+     */
+    class ReactorCall
+    {
+    public:
+        using response_t = system::Response;
+        using callback_t = system::reactor::callback_t;
+
+        void operator () (const Task &task, callback_t callback)
+        {
+            using namespace system::spawn;
+            Pipe pipe;
+            pid_t pid;
+            try {
+                pid = spawn_process(to_arguments(task.command),
+                                    pipe.writeEnd());
+            } catch (const system::error::SpawnFailed &error) {
+                system::capture::OutputBuffer output;
+                output.append(error.what());
+                callback(system::make_response(false, output));
+                return;
+            }
+            reactor.supervise(pid, pipe.releaseReadEnd(), task.output_limit,
+                              to_timeout(task.timeout), callback);
+        }
+
+    private:
+        system::reactor::Reactor reactor;
+    };
+}
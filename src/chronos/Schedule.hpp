@@ -1,54 +1,975 @@
 #pragma once
 #include "boost/date_time/posix_time/posix_time_types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
 #include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
+#include "chronos/Task.hpp"
 
 
+namespace chronos::schedule::detail
+{
+    using tick_t = std::int64_t;
+
+    tick_t floor_div(tick_t value, tick_t divisor)
+    {
+        return time::epoch::floor_div(value, divisor);
+    }
+
+    tick_t floor_mod(tick_t value, tick_t divisor)
+    {
+        return value - floor_div(value, divisor) * divisor;
+    }
+
+    tick_t to_ticks(time::epoch::epoch_t time)
+    {
+        constexpr tick_t MICROSECONDS_IN_SECOND { 1000000 };
+        return floor_div(time, MICROSECONDS_IN_SECOND);
+    }
+
+    template <typename EntryT>
+    bool earlier(const EntryT &lhs, const EntryT &rhs)
+    {
+        return lhs.time < rhs.time;
+    }
+
+    template <typename RecordT>
+    struct Definition
+    {
+        std::string_view command;
+        std::string_view group;
+        const RecordT *record;
+    };
+
+    template <typename RecordT>
+    struct DefinitionHash
+    {
+        std::size_t operator () (const Definition<RecordT> &definition) const
+        {
+            const std::hash<std::string_view> command_hash;
+            return command_hash(definition.command)
+                ^ (definition_hash(*definition.record) << 1);
+        }
+    };
+
+    template <typename RecordT>
+    struct DefinitionEqual
+    {
+        bool operator () (const Definition<RecordT> &lhs,
+                          const Definition<RecordT> &rhs) const
+        {
+            return lhs.command == rhs.command
+                && lhs.group == rhs.group
+                && same_definition(*lhs.record, *rhs.record);
+        }
+    };
+}
+
+namespace chronos::schedule
+{
+    /*
+     * New task definitions of a reload, indexed before the schedule is
+     * touched so that it is held only while they are compared with its
+     * tasks. Views the tasks it was planned from, which must outlive it.
+     */
+    template <typename TaskT, typename RecordT>
+    class ReloadPlan
+    {
+    public:
+        using definition_t = detail::Definition<RecordT>;
+        using hash_t = detail::DefinitionHash<RecordT>;
+        using equal_t = detail::DefinitionEqual<RecordT>;
+
+        explicit ReloadPlan(const std::vector<TaskT> &tasks)
+            : task_count(tasks.size())
+        {
+            records.reserve(tasks.size());
+            for (const auto &task : tasks) {
+                records.push_back(to_record(task));
+                const definition_t definition {
+                    task.command, task.group.name, &records.back() };
+                defined.insert(definition);
+                pending.emplace(definition, &task);
+            }
+        }
+
+        ReloadPlan(const ReloadPlan&) = delete;
+        ReloadPlan& operator = (const ReloadPlan&) = delete;
+
+        std::size_t task_count;
+        std::vector<RecordT> records;
+        std::unordered_set<definition_t, hash_t, equal_t> defined;
+        std::unordered_multimap<definition_t, const TaskT*,
+                hash_t, equal_t> pending;
+    };
+}
+
+namespace chronos::schedule
+{
+    using index_t = std::uint32_t;
+
+    template <typename TimeT>
+    struct Entry
+    {
+        TimeT time;
+        index_t index;
+    };
+
+    template <typename TimeT>
+    bool operator < (const Entry<TimeT> &lhs, const Entry<TimeT> &rhs)
+    {
+        return lhs.time > rhs.time;
+    }
+
+    struct ReloadSummary
+    {
+        std::size_t kept { 0 };
+        std::size_t added { 0 };
+        std::size_t removed { 0 };
+    };
+}
+
+namespace chronos::schedule
+{
+    /*
+     * Keeps every distinct command once, under a small id shared by all
+     * the tasks running it. Characters of all commands live in a single
+     * buffer indexed by an open addressing table of ids; the buffer is
+     * compacted once released commands take more space than live ones.
+     */
+    class CommandPool
+    {
+    public:
+        using id_t = std::uint32_t;
+
+        id_t intern(std::string_view command)
+        {
+            auto &bucket { table[findBucket(command)] };
+            if (bucket == EMPTY_BUCKET) {
+                bucket = allocateId(command);
+                ++used_buckets;
+                if (used_buckets * 2 > table.size())
+                    rehash(table.size() * 2);
+            }
+            ++references[bucket];
+            return bucket;
+        }
+
+        void release(id_t id)
+        {
+            if (--references[id])
+                return;
+            table[findBucket(get(id))] = REMOVED_BUCKET;
+            released_size += spans[id].length;
+            free_ids.push_back(id);
+            if (released_size > characters.size() / 2)
+                compact();
+        }
+
+        [[nodiscard]] std::string_view get(id_t id) const
+        {
+            const auto &span { spans[id] };
+            return { characters.data() + span.offset, span.length };
+        }
+
+    private:
+        struct Span
+        {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        static constexpr id_t EMPTY_BUCKET {
+            std::numeric_limits<id_t>::max() };
+        static constexpr id_t REMOVED_BUCKET { EMPTY_BUCKET - 1 };
+        static constexpr std::size_t INITIAL_TABLE_SIZE { 64 };
+
+        std::size_t findBucket(std::string_view command) const
+        {
+            const auto mask { table.size() - 1 };
+            auto bucket { std::hash<std::string_view>()(command) & mask };
+            std::optional<std::size_t> reusable;
+            for (; table[bucket] != EMPTY_BUCKET; bucket = (bucket + 1) & mask)
+                if (table[bucket] == REMOVED_BUCKET) {
+                    if (!reusable)
+                        reusable = bucket;
+                } else if (get(table[bucket]) == command) {
+                    return bucket;
+                }
+            return reusable.value_or(bucket);
+        }
+
+        id_t allocateId(std::string_view command)
+        {
+            const Span span {
+                static_cast<std::uint32_t>(characters.size()),
+                static_cast<std::uint32_t>(command.size()) };
+            characters.append(command);
+            if (free_ids.empty()) {
+                spans.push_back(span);
+                references.push_back(0);
+                return spans.size() - 1;
+            }
+            const auto id { free_ids.back() };
+            free_ids.pop_back();
+            spans[id] = span;
+            return id;
+        }
+
+        void rehash(std::size_t size)
+        {
+            table.assign(size, EMPTY_BUCKET);
+            used_buckets = 0;
+            for (id_t id = 0; id < spans.size(); ++id)
+                if (references[id]) {
+                    table[findBucket(get(id))] = id;
+                    ++used_buckets;
+                }
+        }
+
+        void compact()
+        {
+            std::string live_characters;
+            live_characters.reserve(characters.size() - released_size);
+            for (id_t id = 0; id < spans.size(); ++id)
+                if (references[id]) {
+                    const auto command { get(id) };
+                    spans[id].offset = live_characters.size();
+                    live_characters.append(command);
+                } else {
+                    spans[id] = { 0, 0 };
+                }
+            characters = std::move(live_characters);
+            released_size = 0;
+            rehash(table.size());
+        }
+
+        std::string characters;
+        std::vector<Span> spans;
+        std::vector<std::uint32_t> references;
+        std::vector<id_t> free_ids;
+        std::vector<id_t> table =
+                std::vector<id_t>(INITIAL_TABLE_SIZE, EMPTY_BUCKET);
+        std::size_t used_buckets { 0 };
+        std::size_t released_size { 0 };
+    };
+
+    /*
+     * Struct-of-arrays task storage. A slot holds the interned command
+     * and group name ids and the packed task record; execution times
+     * live only in queue entries. Handles combine the slot index with a generation, so a
+     * handle of a released slot never matches its next occupant.
+     */
+    template <typename TaskT>
+    class TaskArena
+    {
+    public:
+        using handle_t = decltype(TaskT::handle);
+        using time_t = decltype(TaskT::time);
+        using record_t = decltype(to_record(std::declval<TaskT>()));
+
+        enum class State : std::uint8_t
+        {
+            FREE,
+            QUEUED,
+            WITHDRAWN
+        };
+
+        [[nodiscard]] index_t size() const
+        {
+            return states.size();
+        }
+
+        index_t store(const TaskT &task)
+        {
+            const auto index { allocate() };
+            command_ids[index] = commands.intern(task.command);
+            group_ids[index] = task.group.name.empty()
+                ? NO_GROUP : commands.intern(task.group.name);
+            records[index] = to_record(task);
+            states[index] = State::QUEUED;
+            return index;
+        }
+
+        void assign(index_t index, const TaskT &task)
+        {
+            records[index] = to_record(task);
+        }
+
+        void release(index_t index)
+        {
+            commands.release(command_ids[index]);
+            if (group_ids[index] != NO_GROUP)
+                commands.release(group_ids[index]);
+            states[index] = State::FREE;
+            ++generations[index];
+            free_slots.push_back(index);
+        }
+
+        [[nodiscard]] State state(index_t index) const
+        {
+            return states[index];
+        }
+
+        void setState(index_t index, State state)
+        {
+            states[index] = state;
+        }
+
+        [[nodiscard]] std::optional<index_t> locate(handle_t handle) const
+        {
+            const auto index { static_cast<index_t>(handle) };
+            const auto generation { handle >> GENERATION_SHIFT };
+            if (index >= size() || states[index] == State::FREE
+                || generations[index] != generation)
+                return std::nullopt;
+            return index;
+        }
+
+        [[nodiscard]] handle_t handle(index_t index) const
+        {
+            return static_cast<handle_t>(generations[index])
+                << GENERATION_SHIFT | index;
+        }
+
+        [[nodiscard]] std::string_view command(index_t index) const
+        {
+            return commands.get(command_ids[index]);
+        }
+
+        [[nodiscard]] std::string_view group(index_t index) const
+        {
+            if (group_ids[index] == NO_GROUP)
+                return {};
+            return commands.get(group_ids[index]);
+        }
+
+        [[nodiscard]] const record_t& record(index_t index) const
+        {
+            return records[index];
+        }
+
+        [[nodiscard]] TaskT load(index_t index, const time_t &time) const
+        {
+            return to_task(records[index], command(index), group(index),
+                           time, handle(index));
+        }
+
+    private:
+        static constexpr auto GENERATION_SHIFT { 32 };
+        static constexpr CommandPool::id_t NO_GROUP {
+            std::numeric_limits<CommandPool::id_t>::max() };
+
+        index_t allocate()
+        {
+            if (!free_slots.empty()) {
+                const auto index { free_slots.back() };
+                free_slots.pop_back();
+                return index;
+            }
+            command_ids.emplace_back();
+            group_ids.emplace_back();
+            records.emplace_back();
+            generations.push_back(1);
+            states.push_back(State::FREE);
+            return states.size() - 1;
+        }
+
+        CommandPool commands;
+        std::vector<CommandPool::id_t> command_ids;
+        std::vector<CommandPool::id_t> group_ids;
+        std::vector<record_t> records;
+        std::vector<std::uint32_t> generations;
+        std::vector<State> states;
+        std::vector<index_t> free_slots;
+    };
+}
+
+namespace chronos::schedule
+{
+    /*
+     * D-ary min-heap of queue entries tracking the position of every
+     * entry by its slot index, so a single queued task can be found,
+     * moved or removed in place.
+     */
+    template <typename EntryT, typename ClockT>
+    class IndexedHeap
+    {
+    public:
+        using time_t = decltype(EntryT::time);
+
+        [[nodiscard]] bool empty() const
+        {
+            return heap.empty();
+        }
+
+        void push(const EntryT &entry)
+        {
+            if (entry.index >= positions.size())
+                positions.resize(entry.index + 1, NO_POSITION);
+            heap.push_back(entry);
+            positions[entry.index] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+        }
+
+        [[nodiscard]] const EntryT& top() const
+        {
+            return heap.front();
+        }
+
+        EntryT pop()
+        {
+            return removeAt(0);
+        }
+
+        [[nodiscard]] const EntryT* find(index_t index) const
+        {
+            if (!contains(index))
+                return nullptr;
+            return &heap[positions[index]];
+        }
+
+        bool erase(index_t index)
+        {
+            if (!contains(index))
+                return false;
+            removeAt(positions[index]);
+            return true;
+        }
+
+        bool update(index_t index, const time_t &time)
+        {
+            if (!contains(index))
+                return false;
+            heap[positions[index]].time = time;
+            restore(positions[index]);
+            return true;
+        }
+
+    private:
+        using position_t = std::uint32_t;
+
+        static constexpr std::size_t ARITY { 4 };
+        static constexpr position_t NO_POSITION {
+            std::numeric_limits<position_t>::max() };
+
+        [[nodiscard]] bool contains(index_t index) const
+        {
+            return index < positions.size()
+                && positions[index] != NO_POSITION;
+        }
+
+        EntryT removeAt(std::size_t position)
+        {
+            const auto entry { heap[position] };
+            positions[entry.index] = NO_POSITION;
+            const auto last { heap.back() };
+            heap.pop_back();
+            if (position < heap.size()) {
+                heap[position] = last;
+                positions[last.index] = position;
+                restore(position);
+            }
+            return entry;
+        }
+
+        void restore(std::size_t position)
+        {
+            siftUp(position);
+            siftDown(position);
+        }
+
+        void siftUp(std::size_t position)
+        {
+            while (position > 0) {
+                const auto parent { (position - 1) / ARITY };
+                if (!detail::earlier(heap[position], heap[parent]))
+                    return;
+                swapAt(position, parent);
+                position = parent;
+            }
+        }
+
+        void siftDown(std::size_t position)
+        {
+            while (true) {
+                const auto first_child { position * ARITY + 1 };
+                const auto last_child {
+                    std::min(first_child + ARITY, heap.size()) };
+                auto earliest { position };
+                for (auto child = first_child; child < last_child; ++child)
+                    if (detail::earlier(heap[child], heap[earliest]))
+                        earliest = child;
+                if (earliest == position)
+                    return;
+                swapAt(position, earliest);
+                position = earliest;
+            }
+        }
+
+        void swapAt(std::size_t lhs, std::size_t rhs)
+        {
+            std::swap(heap[lhs], heap[rhs]);
+            positions[heap[lhs].index] = lhs;
+            positions[heap[rhs].index] = rhs;
+        }
+
+        std::vector<EntryT> heap;
+        std::vector<position_t> positions;
+    };
+
+    /*
+     * Hierarchical timing wheel with second, minute, hour and day levels.
+     * An entry is placed on the lowest level whose span it shares with the
+     * cursor and is cascaded down when the cursor enters its slot. Entries
+     * beyond the day level wait in the overflow heap, entries earlier than
+     * the cursor in the expired heap. Erased and updated entries are not
+     * searched for, their placed copies go stale and are dropped when the
+     * cursor reaches them.
+     */
+    template <typename EntryT, typename ClockT>
+    class TimingWheel
+    {
+    private:
+        using tick_t = detail::tick_t;
+
+        // Copy of an entry as placed, current while its version is
+        struct Placed : EntryT
+        {
+            std::uint32_t version;
+        };
+
+        struct Tracked
+        {
+            EntryT entry;
+            std::uint32_t version { 0 };
+            bool queued { false };
+        };
+
+        using slot_t = std::vector<Placed>;
+        using heap_t = std::priority_queue<Placed, std::vector<Placed> >;
+
+        struct Level
+        {
+            tick_t resolution;
+            std::vector<slot_t> slots;
+
+            [[nodiscard]] tick_t span() const
+            {
+                return resolution * static_cast<tick_t>(slots.size());
+            }
+
+            [[nodiscard]] std::size_t index(tick_t tick) const
+            {
+                const auto slots_count { static_cast<tick_t>(slots.size()) };
+                return detail::floor_mod(
+                        detail::floor_div(tick, resolution), slots_count);
+            }
+
+            [[nodiscard]] tick_t start(tick_t tick) const
+            {
+                return detail::floor_div(tick, span()) * span();
+            }
+        };
+
+        static constexpr std::size_t LEVELS_COUNT { 4 };
+        using levels_t = std::array<Level, LEVELS_COUNT>;
+
+    public:
+        using time_t = decltype(EntryT::time);
+
+        TimingWheel()
+            : cursor(detail::to_ticks(
+                    time::epoch::to_epoch(ClockT::local_time()))),
+            levels(create_levels()) { }
+
+        [[nodiscard]] bool empty() const
+        {
+            return !entries_count;
+        }
+
+        void push(const EntryT &entry)
+        {
+            if (entry.index >= tracked.size())
+                tracked.resize(entry.index + 1);
+            auto &current { tracked[entry.index] };
+            current.entry = entry;
+            current.queued = true;
+            place({ entry, ++current.version });
+            ++entries_count;
+        }
+
+        [[nodiscard]] const EntryT& top() const
+        {
+            advance();
+            if (!expired.empty())
+                return expired.top();
+            const auto &slot { currentSlot() };
+            return *std::min_element(begin(slot), end(slot),
+                                     detail::earlier<Placed>);
+        }
+
+        EntryT pop()
+        {
+            advance();
+            --entries_count;
+            if (!expired.empty()) {
+                const EntryT entry { expired.top() };
+                expired.pop();
+                tracked[entry.index].queued = false;
+                return entry;
+            }
+            auto &slot { currentSlot() };
+            const auto next { std::min_element(begin(slot), end(slot),
+                                               detail::earlier<Placed>) };
+            std::iter_swap(next, slot.end() - 1);
+            const EntryT entry { slot.back() };
+            slot.pop_back();
+            tracked[entry.index].queued = false;
+            return entry;
+        }
+
+        [[nodiscard]] const EntryT* find(index_t index) const
+        {
+            if (!contains(index))
+                return nullptr;
+            return &tracked[index].entry;
+        }
+
+        bool erase(index_t index)
+        {
+            if (!contains(index))
+                return false;
+            tracked[index].queued = false;
+            --entries_count;
+            return true;
+        }
+
+        bool update(index_t index, const time_t &time)
+        {
+            if (!contains(index))
+                return false;
+            auto &current { tracked[index] };
+            current.entry.time = time;
+            place({ current.entry, ++current.version });
+            return true;
+        }
+
+    private:
+        static levels_t create_levels()
+        {
+            constexpr tick_t SECOND { 1 };
+            constexpr tick_t MINUTE { 60 * SECOND };
+            constexpr tick_t HOUR { 60 * MINUTE };
+            constexpr tick_t DAY { 24 * HOUR };
+            constexpr std::size_t DAYS_SLOTS_COUNT { 32 };
+            return {
+                Level { SECOND, std::vector<slot_t>(60) },
+                Level { MINUTE, std::vector<slot_t>(60) },
+                Level { HOUR, std::vector<slot_t>(24) },
+                Level { DAY, std::vector<slot_t>(DAYS_SLOTS_COUNT) } };
+        }
+
+        [[nodiscard]] bool contains(index_t index) const
+        {
+            return index < tracked.size() && tracked[index].queued;
+        }
+
+        [[nodiscard]] bool isStale(const Placed &placed) const
+        {
+            const auto &current { tracked[placed.index] };
+            return !current.queued || current.version != placed.version;
+        }
+
+        slot_t& currentSlot() const
+        {
+            auto &seconds_level { levels.front() };
+            return seconds_level.slots[seconds_level.index(cursor)];
+        }
+
+        void place(const Placed &entry) const
+        {
+            const auto tick { detail::to_ticks(entry.time) };
+            if (tick < cursor) {
+                expired.push(entry);
+                return;
+            }
+            for (auto &level : levels)
+                if (level.start(tick) == level.start(cursor)) {
+                    level.slots[level.index(tick)].push_back(entry);
+                    return;
+                }
+            overflow.push(entry);
+        }
+
+        void advance() const
+        {
+            dropStale();
+            while (expired.empty() && currentSlot().empty()) {
+                if (!advanceWithinLevels() && !pullOverflow())
+                    return;
+                dropStale();
+            }
+        }
+
+        void dropStale() const
+        {
+            while (!expired.empty() && isStale(expired.top()))
+                expired.pop();
+            auto &slot { currentSlot() };
+            slot.erase(std::remove_if(begin(slot), end(slot),
+                    [this] (const Placed &placed) {
+                        return isStale(placed); }),
+                    end(slot));
+        }
+
+        bool advanceWithinLevels() const
+        {
+            auto &seconds_level { levels.front() };
+            for (auto i = seconds_level.index(cursor) + 1;
+                 i < seconds_level.slots.size(); ++i)
+                if (!seconds_level.slots[i].empty()) {
+                    cursor = seconds_level.start(cursor)
+                            + static_cast<tick_t>(i);
+                    return true;
+                }
+            for (std::size_t level = 1; level < LEVELS_COUNT; ++level)
+                if (cascadeNextSlot(level))
+                    return true;
+            return false;
+        }
+
+        bool cascadeNextSlot(std::size_t level_number) const
+        {
+            auto &level { levels[level_number] };
+            for (auto i = level.index(cursor) + 1;
+                 i < level.slots.size(); ++i)
+                if (!level.slots[i].empty()) {
+                    cursor = level.start(cursor)
+                            + static_cast<tick_t>(i) * level.resolution;
+                    slot_t slot;
+                    std::swap(slot, level.slots[i]);
+                    for (const auto &entry : slot)
+                        place(entry);
+                    return true;
+                }
+            return false;
+        }
+
+        bool pullOverflow() const
+        {
+            if (overflow.empty())
+                return false;
+            const auto &days_level { levels.back() };
+            const auto block_start {
+                days_level.start(detail::to_ticks(overflow.top().time)) };
+            cursor = std::max(cursor, block_start);
+            while (!overflow.empty()
+                   && days_level.start(detail::to_ticks(overflow.top().time))
+                      == days_level.start(cursor)) {
+                const auto entry { overflow.top() };
+                overflow.pop();
+                place(entry);
+            }
+            return true;
+        }
+
+        // Advancing the cursor reorganizes slots without changing contents,
+        // so it is allowed in const lookups.
+        mutable tick_t cursor;
+        mutable levels_t levels;
+        mutable heap_t expired;
+        mutable heap_t overflow;
+        std::vector<Tracked> tracked;
+        std::size_t entries_count { 0 };
+    };
+}
+
 namespace chronos
 {
-    template <typename TaskT, typename ClockT>
+    template <typename TaskT, typename ClockT,
+              template <typename, typename> class QueueT =
+                      schedule::IndexedHeap>
     class Schedule
     {
+    private:
+        using arena_t = schedule::TaskArena<TaskT>;
+        using record_t = typename arena_t::record_t;
+        using state_t = typename arena_t::State;
+        using index_t = schedule::index_t;
+
     public:
         using duration_t = boost::posix_time::time_duration;
         using task_t = TaskT;
+        using handle_t = typename arena_t::handle_t;
+        using time_t = typename arena_t::time_t;
+        // Queues order tasks by integer times, tasks carry Boost ones
+        using entry_t = schedule::Entry<time::epoch::epoch_t>;
+        using reload_plan_t = schedule::ReloadPlan<TaskT, record_t>;
 
         [[nodiscard]] bool isEmpty() const
         {
             return queue.empty();
         }
 
-        void add(const TaskT &task)
+        handle_t add(const TaskT &task)
         {
-            queue.push(task);
+            const auto index { arena.store(task) };
+            queue.push({ time::epoch::to_epoch(task.time), index });
+            return arena.handle(index);
         }
 
         void reschedule(TaskT &task)
         {
             transit(task);
-            queue.push(task);
+            if (!task.handle) {
+                task.handle = add(task);
+                return;
+            }
+            const auto index { arena.locate(task.handle) };
+            // A task cancelled while withdrawn is not brought back
+            if (!index)
+                return;
+            if (arena.state(*index) != state_t::WITHDRAWN) {
+                task.handle = add(task);
+                return;
+            }
+            arena.assign(*index, task);
+            arena.setState(*index, state_t::QUEUED);
+            queue.push({ time::epoch::to_epoch(task.time), *index });
         }
 
         void retry(const TaskT &task)
         {
-            auto retry_task { create_retry(task) };
-            queue.push(retry_task);
+            add(create_retry(task));
+        }
+
+        bool cancel(handle_t handle)
+        {
+            const auto index { arena.locate(handle) };
+            if (!index)
+                return false;
+            discard(*index);
+            return true;
+        }
+
+        bool update(handle_t handle, const time_t &time)
+        {
+            const auto index { arena.locate(handle) };
+            return index
+                && queue.update(*index, time::epoch::to_epoch(time));
+        }
+
+        [[nodiscard]] std::optional<TaskT> find(handle_t handle) const
+        {
+            const auto index { arena.locate(handle) };
+            if (!index || arena.state(*index) != state_t::QUEUED)
+                return std::nullopt;
+            return arena.load(*index,
+                              time::epoch::from_epoch(queue.find(*index)->time));
+        }
+
+        /*
+         * Brings the schedule in line with a new set of task definitions.
+         * Tasks whose definition is still present keep their time and
+         * pending retries; only vanished and new definitions touch
+         * the queue.
+         */
+        schedule::ReloadSummary reload(const std::vector<TaskT> &tasks)
+        {
+            reload_plan_t plan(tasks);
+            return reload(plan);
+        }
+
+        // Consumes a plan made ahead with the new task definitions
+        schedule::ReloadSummary reload(reload_plan_t &plan)
+        {
+            using definition_t = typename reload_plan_t::definition_t;
+
+            std::vector<index_t> removed;
+            for (index_t index = 0; index < arena.size(); ++index) {
+                if (arena.state(index) == state_t::FREE)
+                    continue;
+                const definition_t definition { arena.command(index),
+                    arena.group(index), &arena.record(index) };
+                if (is_retry(arena.record(index))) {
+                    if (plan.defined.find(definition) == plan.defined.end())
+                        removed.push_back(index);
+                    continue;
+                }
+                const auto match { plan.pending.find(definition) };
+                if (match == plan.pending.end())
+                    removed.push_back(index);
+                else
+                    plan.pending.erase(match);
+            }
+
+            for (const auto index : removed)
+                discard(index);
+            for (const auto &[definition, task] : plan.pending)
+                add(*task);
+
+            schedule::ReloadSummary summary;
+            summary.kept = plan.task_count - plan.pending.size();
+            summary.added = plan.pending.size();
+            summary.removed = removed.size();
+            return summary;
         }
 
         [[nodiscard]] duration_t timeToNextTask() const
         {
-            const auto task { queue.top() };
-            return task.time - ClockT::local_time();
+            if (queue.empty())
+                return duration_t(boost::posix_time::pos_infin);
+            const auto time { queue.top().time };
+            const auto now { time::epoch::to_epoch(ClockT::local_time()) };
+            if (time::epoch::is_special(time) || time::epoch::is_special(now))
+                return time::epoch::from_epoch(time) - ClockT::local_time();
+            return boost::posix_time::microseconds(time - now);
+        }
+
+        std::vector<TaskT> withdrawDueTasks(const time_t &now)
+        {
+            const auto now_time { time::epoch::to_epoch(now) };
+            std::vector<TaskT> tasks;
+            while (!queue.empty() && !(now_time < queue.top().time))
+                tasks.push_back(withdrawNextTask());
+            return tasks;
+        }
+
+        std::vector<TaskT> withdrawDueTasks()
+        {
+            return withdrawDueTasks(ClockT::local_time());
         }
 
         TaskT withdrawNextTask()
         {
-            auto task { queue.top() };
-            queue.pop();
+            const auto entry { queue.pop() };
+            auto task { arena.load(entry.index,
+                                   time::epoch::from_epoch(entry.time)) };
+            if (is_retry(task))
+                arena.release(entry.index);
+            else
+                arena.setState(entry.index, state_t::WITHDRAWN);
             return task;
         }
 
     private:
-        std::priority_queue<TaskT, std::vector<TaskT> > queue;
+        void discard(index_t index)
+        {
+            if (arena.state(index) == state_t::QUEUED)
+                queue.erase(index);
+            arena.release(index);
+        }
+
+        arena_t arena;
+        QueueT<entry_t, ClockT> queue;
     };
 }
@@ -1,5 +1,14 @@
 #pragma once
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "chronos/Task.hpp"
+
+extern char **environ;
 
 
 namespace chronos::system::error
@@ -9,11 +18,133 @@ namespace chronos::system::error
     public:
         PipeOpeningFailed() : std::runtime_error("Pipe opening failed") { }
     };
+
+    class SpawnFailed : public std::runtime_error
+    {
+    public:
+        SpawnFailed(const std::string &command, int error_number)
+            : std::runtime_error("Spawning \"" + command + "\" failed: "
+                                 + std::strerror(error_number)) { }
+    };
+}
+
+namespace chronos::system::capture
+{
+    /*
+     * Output of a command kept within a fixed number of bytes. The first
+     * half of the limit keeps the head of the output, the second half is
+     * a ring holding its tail; whatever falls in between is only counted.
+     * Storage is allocated at the first write, silent commands cost
+     * nothing.
+     */
+    class OutputBuffer
+    {
+    public:
+        explicit OutputBuffer(
+                std::size_t limit = task::constants::DEFAULT_OUTPUT_LIMIT)
+            : limit(limit), head_capacity(limit / 2) { }
+
+        void append(const char *data, std::size_t size)
+        {
+            if (!buffer && limit)
+                buffer = std::make_unique<char[]>(limit);
+            const auto linear_count {
+                std::min(size, limit - std::min(written, limit)) };
+            std::copy_n(data, linear_count, buffer.get() + written);
+            written += size;
+            data += linear_count;
+            size -= linear_count;
+
+            const auto tail_capacity { limit - head_capacity };
+            if (!size || !tail_capacity)
+                return;
+            if (size > tail_capacity) {
+                data += size - tail_capacity;
+                size = tail_capacity;
+            }
+            while (size) {
+                const auto count {
+                    std::min(size, tail_capacity - tail_start) };
+                std::copy_n(data, count, tail() + tail_start);
+                tail_start = (tail_start + count) % tail_capacity;
+                data += count;
+                size -= count;
+            }
+        }
+
+        void append(std::string_view text)
+        {
+            append(text.data(), text.size());
+        }
+
+        // Puts the tail in order; the view is valid until the next write
+        std::string_view view()
+        {
+            if (tail_start) {
+                const auto tail_end { buffer.get() + limit };
+                std::rotate(tail(), tail() + tail_start, tail_end);
+                tail_start = 0;
+            }
+            return { buffer.get(), std::min(written, limit) };
+        }
+
+        [[nodiscard]] std::size_t droppedBytes() const
+        {
+            return written - std::min(written, limit);
+        }
+
+        // Position in the view where the dropped bytes used to be
+        [[nodiscard]] std::size_t droppedAt() const
+        {
+            return droppedBytes() ? head_capacity : 0;
+        }
+
+    private:
+        char* tail()
+        {
+            return buffer.get() + head_capacity;
+        }
+
+        std::size_t limit;
+        std::size_t head_capacity;
+        std::size_t written { 0 };
+        std::size_t tail_start { 0 };
+        std::unique_ptr<char[]> buffer;
+    };
+}
+
+namespace chronos::system
+{
+    /*
+     * Outcome of an execution. The message is a view into the output
+     * buffer of the execution and is valid only until it runs again or,
+     * for asynchronous executions, until the callback returns.
+     */
+    struct Response
+    {
+        bool success;
+        std::string_view message;
+        std::size_t dropped_bytes { 0 };
+        std::size_t dropped_at { 0 };
+        bool timed_out { false };
+    };
+
+    Response make_response(bool success, capture::OutputBuffer &output,
+                           bool timed_out = false)
+    {
+        Response response;
+        response.success = success && !timed_out;
+        response.message = output.view();
+        response.dropped_bytes = output.droppedBytes();
+        response.dropped_at = output.droppedAt();
+        response.timed_out = timed_out;
+        return response;
+    }
 }
 
 namespace chronos::system::pipe
 {
-    static constexpr auto MESSAGE_BUFFER_SIZE { 128 };
+    static constexpr auto MESSAGE_BUFFER_SIZE { 4096 };
     static constexpr auto RETURN_CODE_OK { 0 };
     static constexpr auto PIPE_TYPE { "r" };
 
@@ -42,18 +173,16 @@ namespace chronos::system::pipe
     {
     public:
         using message_buffer_t = std::array<char, MESSAGE_BUFFER_SIZE>;
-        using message_t = std::string;
 
         explicit ReadPipe(const std::string &command)
             : pipe(open_pipe(command)) { };
 
-        message_t drain()
+        void drain(capture::OutputBuffer &output)
         {
-            std::string output;
             message_buffer_t buffer;
-            while (fgets(buffer.data(), buffer.size(), pipe))
-                output.append(buffer.data());
-            return output;
+            while (const auto count {
+                    fread(buffer.data(), 1, buffer.size(), pipe) })
+                output.append(buffer.data(), count);
         }
 
         bool close()
@@ -66,27 +195,327 @@ namespace chronos::system::pipe
     };
 }
 
-namespace chronos::system
+namespace chronos::system::spawn
 {
-    struct Response
+    static constexpr auto SHELL_PATH { "/bin/sh" };
+    static constexpr auto SHELL_COMMAND_OPTION { "-c" };
+    static constexpr auto READ_BUFFER_SIZE { 4096 };
+    static constexpr std::chrono::seconds TERMINATION_GRACE_PERIOD { 5 };
+    static constexpr std::chrono::milliseconds MAX_EXIT_POLL_INTERVAL { 50 };
+
+    using arguments_t = std::vector<std::string>;
+    using timeout_t = std::chrono::seconds;
+    using deadline_t = std::chrono::steady_clock::time_point;
+
+    timeout_t to_timeout(const time_duration_t &duration)
     {
-        bool success;
-        std::string message;
+        return timeout_t(duration.total_seconds());
+    }
+
+    arguments_t tokenize(const std::string &command)
+    {
+        arguments_t arguments;
+        std::istringstream stream(command);
+        for (std::string argument; stream >> argument; )
+            arguments.push_back(argument);
+        return arguments;
+    }
+
+    bool is_shell_builtin(const std::string &program)
+    {
+        static const std::set<std::string> BUILTINS {
+            ".", "alias", "cd", "eval", "exec", "exit", "export", "read",
+            "set", "source", "trap", "ulimit", "umask", "unset", "wait" };
+        return BUILTINS.count(program);
+    }
+
+    bool requires_shell(const std::string &command)
+    {
+        constexpr std::string_view SHELL_SYNTAX {
+            "|&;<>()$`\\\"'*?[]#~{}\n" };
+        if (command.find_first_of(SHELL_SYNTAX) != std::string::npos)
+            return true;
+        const auto arguments { tokenize(command) };
+        return arguments.empty()
+            || arguments.front().find('=') != std::string::npos
+            || is_shell_builtin(arguments.front());
+    }
+
+    arguments_t to_arguments(const std::string &command)
+    {
+        if (requires_shell(command))
+            return { SHELL_PATH, SHELL_COMMAND_OPTION, command };
+        return tokenize(command);
+    }
+
+    class Pipe
+    {
+    public:
+        Pipe()
+        {
+            if (pipe2(descriptors.data(), O_CLOEXEC))
+                throw error::PipeOpeningFailed();
+        }
+
+        ~Pipe()
+        {
+            closeReadEnd();
+            closeWriteEnd();
+        }
+
+        [[nodiscard]] int readEnd() const
+        {
+            return descriptors[READ_END];
+        }
+
+        [[nodiscard]] int writeEnd() const
+        {
+            return descriptors[WRITE_END];
+        }
+
+        void closeReadEnd()
+        {
+            close(READ_END);
+        }
+
+        int releaseReadEnd()
+        {
+            const auto descriptor { descriptors[READ_END] };
+            descriptors[READ_END] = CLOSED;
+            return descriptor;
+        }
+
+        void closeWriteEnd()
+        {
+            close(WRITE_END);
+        }
+
+    private:
+        static constexpr std::size_t READ_END { 0 };
+        static constexpr std::size_t WRITE_END { 1 };
+        static constexpr int CLOSED { -1 };
+
+        void close(std::size_t end)
+        {
+            if (descriptors[end] != CLOSED)
+                ::close(descriptors[end]);
+            descriptors[end] = CLOSED;
+        }
+
+        std::array<int, 2> descriptors { CLOSED, CLOSED };
     };
+
+    /*
+     * Starts the program with its output and error streams wired to
+     * the given descriptor. posix_spawn does not copy the address space
+     * of chronos the way fork behind popen does. The program leads its
+     * own process group, so whatever it starts can be stopped with it.
+     */
+    pid_t spawn_process(const arguments_t &arguments, int output)
+    {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, output, STDERR_FILENO);
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attributes, 0);
+
+        std::vector<char*> argv;
+        for (const auto &argument : arguments)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid;
+        const auto error_number { posix_spawnp(
+                &pid, argv.front(), &actions, &attributes, argv.data(),
+                environ) };
+        posix_spawnattr_destroy(&attributes);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error_number)
+            throw error::SpawnFailed(arguments.front(), error_number);
+        return pid;
+    }
+
+    void read_all(int descriptor, capture::OutputBuffer &output)
+    {
+        std::array<char, READ_BUFFER_SIZE> buffer;
+        while (true) {
+            const auto count { read(descriptor, buffer.data(),
+                                    buffer.size()) };
+            if (count > 0)
+                output.append(buffer.data(), count);
+            else if (!count || errno != EINTR)
+                return;
+        }
+    }
+
+    // Reads output until its end, returns false if the deadline came first
+    bool read_within(int descriptor, capture::OutputBuffer &output,
+                     deadline_t deadline)
+    {
+        using namespace std::chrono;
+        std::array<char, READ_BUFFER_SIZE> buffer;
+        while (true) {
+            const auto remaining {
+                ceil<milliseconds>(deadline - steady_clock::now()) };
+            if (remaining.count() <= 0)
+                return false;
+            pollfd readable { descriptor, POLLIN, 0 };
+            if (poll(&readable, 1, remaining.count()) <= 0)
+                continue;
+            const auto count { read(descriptor, buffer.data(),
+                                    buffer.size()) };
+            if (count > 0)
+                output.append(buffer.data(), count);
+            else if (!count || errno != EINTR)
+                return true;
+        }
+    }
+
+    bool succeeded(int status)
+    {
+        return WIFEXITED(status) && !WEXITSTATUS(status);
+    }
+
+    bool wait_for_success(pid_t pid)
+    {
+        int status;
+        while (waitpid(pid, &status, 0) < 0)
+            if (errno != EINTR)
+                return false;
+        return succeeded(status);
+    }
+
+    // Whether the exited process succeeded, or nothing while it runs
+    std::optional<bool> try_reap(pid_t pid)
+    {
+        int status;
+        pid_t reaped;
+        do
+            reaped = waitpid(pid, &status, WNOHANG);
+        while (reaped < 0 && errno == EINTR);
+        if (reaped == pid)
+            return succeeded(status);
+        if (reaped < 0)
+            return false;
+        return std::nullopt;
+    }
+
+    /*
+     * Whether the process succeeded, or nothing if it is still running
+     * at the deadline. A process may close its output long before it
+     * exits, so its end is polled for with growing pauses.
+     */
+    std::optional<bool> wait_within(pid_t pid, deadline_t deadline)
+    {
+        using namespace std::chrono;
+        steady_clock::duration pause { milliseconds(1) };
+        while (true) {
+            if (const auto success { try_reap(pid) })
+                return success;
+            const auto now { steady_clock::now() };
+            if (now >= deadline)
+                return std::nullopt;
+            std::this_thread::sleep_for(std::min(pause, deadline - now));
+            pause = std::min<steady_clock::duration>(pause * 2,
+                                                     MAX_EXIT_POLL_INTERVAL);
+        }
+    }
+
+    // Whether the process finished within the timeout and succeeded
+    std::optional<bool> finish_within(pid_t pid, int output,
+                                      capture::OutputBuffer &captured,
+                                      deadline_t deadline)
+    {
+        if (!read_within(output, captured, deadline))
+            return std::nullopt;
+        return wait_within(pid, deadline);
+    }
+
+    void signal_group(pid_t pid, int signal)
+    {
+        kill(-pid, signal);
+    }
+
+    /*
+     * Asks the process group to terminate and kills it unless its leader
+     * is gone once the grace period is over, whatever its output does.
+     */
+    bool terminate_group(pid_t pid, int output,
+                         capture::OutputBuffer &captured)
+    {
+        signal_group(pid, SIGTERM);
+        const auto grace_deadline {
+            std::chrono::steady_clock::now() + TERMINATION_GRACE_PERIOD };
+        if (const auto success {
+                finish_within(pid, output, captured, grace_deadline) })
+            return *success;
+        signal_group(pid, SIGKILL);
+        return wait_for_success(pid);
+    }
 }
 
 namespace chronos
 {
-    struct SystemCall
+    class SystemCall
     {
+    public:
         using response_t = system::Response;
 
-        response_t operator () (const std::string &command)
+        response_t operator () (const Task &task)
         {
-            system::pipe::ReadPipe pipe(command);
-            const auto message { pipe.drain() };
+            system::pipe::ReadPipe pipe(task.command);
+            output = system::capture::OutputBuffer(task.output_limit);
+            pipe.drain(output);
             const auto success { pipe.close() };
-            return { .success = success, .message = message };
+            return system::make_response(success, output);
         }
+
+    private:
+        system::capture::OutputBuffer output;
+    };
+
+    /*
+     * Runs simple commands directly and reaches for the shell only when
+     * the command uses shell syntax.
+     */
+    class SpawnCall
+    {
+    public:
+        using response_t = system::Response;
+
+        response_t operator () (const Task &task)
+        {
+            using namespace system::spawn;
+            output = system::capture::OutputBuffer(task.output_limit);
+            Pipe pipe;
+            pid_t pid;
+            try {
+                pid = spawn_process(to_arguments(task.command),
+                                    pipe.writeEnd());
+            } catch (const system::error::SpawnFailed &error) {
+                output.append(error.what());
+                return system::make_response(false, output);
+            }
+            pipe.closeWriteEnd();
+            const auto timeout { to_timeout(task.timeout) };
+            if (!timeout.count()) {
+                read_all(pipe.readEnd(), output);
+                const auto success { wait_for_success(pid) };
+                return system::make_response(success, output);
+            }
+            const auto finished { finish_within(pid, pipe.readEnd(), output,
+                    std::chrono::steady_clock::now() + timeout) };
+            if (finished)
+                return system::make_response(*finished, output);
+            const auto success { terminate_group(pid, pipe.readEnd(),
+                                                 output) };
+            return system::make_response(success, output, true);
+        }
+
+    private:
+        system::capture::OutputBuffer output;
     };
 }
@@ -1,13 +1,21 @@
 #pragma once
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
 #include <variant>
+#include <cstdint>
 #include <cstdlib>
 #include "boost/date_time/gregorian/gregorian_types.hpp"
 #include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "chronos/Cron.hpp"
 
 
 namespace chronos
 {
     using command_t = std::string;
+    using handle_t = std::uint64_t;
     using month_t = boost::gregorian::greg_month;
     using retry_count_t = int;
     using time_t = boost::posix_time::ptime;
@@ -23,6 +31,12 @@ namespace chronos
         weeks_duration_t, months_duration_t>;
 }
 
+namespace chronos::task::constants
+{
+    // Bytes of command output kept when the task does not say otherwise
+    constexpr std::uint32_t DEFAULT_OUTPUT_LIMIT { 64 * 1024 };
+}
+
 namespace chronos::time::constants
 {
     constexpr auto MINUTES_IN_HOUR { 60 };
@@ -138,36 +152,9 @@ namespace chronos::time
         return day_time;
     }
 
-    time_t transit(const time_t &time_point, const time_duration_t &duration)
-    {
-        return time_t(time_point + duration);
-    }
-
-    time_t transit(const time_t &time_point, const days_duration_t &duration)
-    {
-        const auto date { time_point.date() };
-        const auto offset { time_point.time_of_day() };
-        return time_t(date + duration, offset);
-    }
-
-    time_t transit(const time_t &time_point, const weeks_duration_t &duration)
-    {
-        const auto date { time_point.date() };
-        const auto offset { time_point.time_of_day() };
-        return time_t(date + duration, offset);
-    }
-
-    time_t transit(const time_t &time_point, const months_duration_t &duration)
-    {
-        const auto date { time_point.date() };
-        const auto offset { time_point.time_of_day() };
-        return time_t(date + duration, offset);
-    }
-
-    template <typename ClockT>
-    time_t closest_future_time_point(const MonthTime &month_time)
+    time_t closest_future_time_point(const MonthTime &month_time,
+                                     const time_t &current_time)
     {
-        const auto current_time { ClockT::local_time() };
         const auto current_date { current_time.date() };
         const auto current_month { current_date.month() };
         const auto current_year { current_date.year() };
@@ -182,11 +169,10 @@ namespace chronos::time
         return time_t(result_date, result_daytime);
     }
 
-    template <typename ClockT>
-    time_t closest_future_time_point(const WeekTime &week_time)
+    time_t closest_future_time_point(const WeekTime &week_time,
+                                     const time_t &current_time)
     {
         using constants::DAYS_IN_WEEK;
-        const auto current_time { ClockT::local_time() };
         const auto current_date { current_time.date() };
         const auto current_week_time { extract_week_time(current_time) };
         const auto days_remaining {
@@ -202,10 +188,9 @@ namespace chronos::time
         return result_time;
     }
 
-    template <typename ClockT>
-    time_t closest_future_time_point(const DayTime &day_time)
+    time_t closest_future_time_point(const DayTime &day_time,
+                                     const time_t &current_time)
     {
-        const auto current_time { ClockT::local_time() };
         const auto current_date { current_time.date() };
         const auto current_hour_time {extract_day_time(current_time) };
         const auto result_daytime {
@@ -216,10 +201,9 @@ namespace chronos::time
         return time_t(result_date, result_daytime);
     }
 
-    template <typename ClockT>
-    time_t closest_future_time_point(hour_time_t hour_time)
+    time_t closest_future_time_point(hour_time_t hour_time,
+                                     const time_t &current_time)
     {
-        const auto current_time { ClockT::local_time() };
         const auto current_daytime { current_time.time_of_day() };
         const auto current_date { current_time.date() };
         const auto current_hour { current_daytime.hours() };
@@ -229,10 +213,14 @@ namespace chronos::time
             ? result_time : result_time + hours_duration_t(1);
     }
 
-    template <typename ClockT>
-    time_t closest_future_time_point()
+    time_t closest_future_time_point(const cron::Expression &expression,
+                                     const time_t &current_time)
+    {
+        return cron::next_fire(expression, current_time);
+    }
+
+    time_t closest_future_time_point(const time_t &current_time)
     {
-        const auto current_time { ClockT::local_time() };
         const auto current_daytime { current_time.time_of_day() };
         const auto current_date { current_time.date() };
         const auto current_hour { current_daytime.hours() };
@@ -240,6 +228,181 @@ namespace chronos::time
         return time_t(current_date,
                 time_duration_t(current_hour, current_minute + 1, NO_SECONDS));
     }
+
+    // Closest time point as seen from the present
+    template <typename ClockT, typename... AlignmentT>
+    time_t closest_future_time_point(const AlignmentT&... alignment)
+    {
+        return closest_future_time_point(alignment..., ClockT::local_time());
+    }
+}
+
+namespace chronos::time::epoch
+{
+    /*
+     * Microseconds since 1970-01-01 00:00, the time kept in schedule
+     * queues, so ordering tasks is comparing integers. Infinity and no
+     * time at all are kept as the largest values.
+     */
+    using epoch_t = std::int64_t;
+
+    constexpr epoch_t POSITIVE_INFINITY {
+        std::numeric_limits<epoch_t>::max() };
+    constexpr epoch_t NOT_A_TIME { POSITIVE_INFINITY - 1 };
+    constexpr epoch_t NEGATIVE_INFINITY {
+        std::numeric_limits<epoch_t>::min() };
+    constexpr epoch_t MICROSECONDS_IN_DAY { 86400ll * 1000000 };
+
+    const time_t EPOCH { date_t(1970, 1, 1) };
+
+    bool is_special(epoch_t time)
+    {
+        return time >= NOT_A_TIME || time == NEGATIVE_INFINITY;
+    }
+
+    epoch_t to_epoch(const time_t &time_point)
+    {
+        if (time_point.is_pos_infinity())
+            return POSITIVE_INFINITY;
+        if (time_point.is_neg_infinity())
+            return NEGATIVE_INFINITY;
+        if (time_point.is_not_a_date_time())
+            return NOT_A_TIME;
+        return (time_point - EPOCH).total_microseconds();
+    }
+
+    time_t from_epoch(epoch_t time)
+    {
+        if (time == POSITIVE_INFINITY)
+            return time_t(boost::posix_time::pos_infin);
+        if (time == NEGATIVE_INFINITY)
+            return time_t(boost::posix_time::neg_infin);
+        if (time == NOT_A_TIME)
+            return time_t(boost::posix_time::not_a_date_time);
+        return EPOCH + boost::posix_time::microseconds(time);
+    }
+
+    std::int64_t floor_div(std::int64_t value, std::int64_t divisor)
+    {
+        const auto quotient { value / divisor };
+        return value % divisor != 0 && value < 0 ? quotient - 1 : quotient;
+    }
+
+    struct CivilDate
+    {
+        std::int64_t year;
+        int month;
+        int day;
+    };
+
+    // Days since the epoch of a proleptic Gregorian date, after H. Hinnant
+    std::int64_t days_from_civil(const CivilDate &civil)
+    {
+        const auto year { civil.year - (civil.month <= 2) };
+        const auto era { floor_div(year, 400) };
+        const auto year_of_era { year - era * 400 };
+        const auto day_of_year {
+            (153 * (civil.month + (civil.month > 2 ? -3 : 9)) + 2) / 5
+            + civil.day - 1 };
+        const auto day_of_era { year_of_era * 365 + year_of_era / 4
+            - year_of_era / 100 + day_of_year };
+        return era * 146097 + day_of_era - 719468;
+    }
+
+    CivilDate civil_from_days(std::int64_t days)
+    {
+        days += 719468;
+        const auto era { floor_div(days, 146097) };
+        const auto day_of_era { days - era * 146097 };
+        const auto year_of_era { (day_of_era - day_of_era / 1460
+            + day_of_era / 36524 - day_of_era / 146096) / 365 };
+        const auto day_of_year { day_of_era - (365 * year_of_era
+            + year_of_era / 4 - year_of_era / 100) };
+        const auto shifted_month { (5 * day_of_year + 2) / 153 };
+        const int day ( day_of_year - (153 * shifted_month + 2) / 5 + 1 );
+        const int month ( shifted_month < 10
+            ? shifted_month + 3 : shifted_month - 9 );
+        return { year_of_era + era * 400 + (month <= 2), month, day };
+    }
+
+    int last_day_of_month(std::int64_t year, int month)
+    {
+        constexpr int DAYS_IN_MONTH[] {
+            31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        const bool leap { year % 4 == 0
+            && (year % 100 != 0 || year % 400 == 0) };
+        return month == 2 && leap ? 29 : DAYS_IN_MONTH[month - 1];
+    }
+
+    /*
+     * Same day in a month that many months later, as Boost adds months:
+     * the last day of a month stays the last day, other days are cut
+     * down to the last day of a shorter month.
+     */
+    epoch_t add_months(epoch_t time, int months)
+    {
+        const auto days { floor_div(time, MICROSECONDS_IN_DAY) };
+        const auto time_of_day { time - days * MICROSECONDS_IN_DAY };
+        const auto civil { civil_from_days(days) };
+        const auto month_index { civil.year * 12 + civil.month - 1 + months };
+        const auto year { floor_div(month_index, 12) };
+        const int month ( month_index - year * 12 + 1 );
+        const auto last_day { last_day_of_month(year, month) };
+        const auto day {
+            civil.day == last_day_of_month(civil.year, civil.month)
+            ? last_day : std::min(civil.day, last_day) };
+        return days_from_civil({ year, month, day }) * MICROSECONDS_IN_DAY
+            + time_of_day;
+    }
+
+    epoch_t transit(epoch_t time, const time_duration_t &duration)
+    {
+        return time + duration.total_microseconds();
+    }
+
+    // Weeks are date durations counted in days as well
+    epoch_t transit(epoch_t time, const days_duration_t &duration)
+    {
+        return time + duration.days() * MICROSECONDS_IN_DAY;
+    }
+
+    epoch_t transit(epoch_t time, const months_duration_t &duration)
+    {
+        return add_months(time, duration.number_of_months().as_number());
+    }
+}
+
+namespace chronos::task
+{
+    enum class Priority : std::uint8_t
+    {
+        LOW,
+        NORMAL,
+        HIGH,
+        CRITICAL
+    };
+
+    // How the first execution time of a task is found from the present
+    enum class Alignment : std::uint8_t
+    {
+        NEXT_MINUTE,
+        MINUTE_OF_HOUR,
+        TIME_OF_DAY,
+        TIME_OF_WEEK,
+        TIME_OF_MONTH,
+        CRON
+    };
+
+    /*
+     * Tasks sharing a group name share its limits: how many of them may
+     * run at once and how many may start per second. Zero means no limit.
+     */
+    struct Group
+    {
+        std::string name;
+        int max_concurrent { 0 };
+        double starts_per_second { 0 };
+    };
 }
 
 namespace chronos
@@ -252,6 +415,25 @@ namespace chronos
         retry_count_t attempts_count { 0 };
         retry_count_t max_retries_count { 0 };
         time_duration_t retry_after;
+        // Cap of exponentially growing retry delays, zero keeps them fixed
+        time_duration_t backoff_limit;
+        // Failures in a row opening the circuit of the command and how
+        // long it stays open, zero keeps the dispatcher defaults
+        int circuit_failures { 0 };
+        time_duration_t circuit_cool_down;
+        // Execution is stopped after that long, zero means no limit
+        time_duration_t timeout;
+        // Window the start time is spread over, zero keeps it aligned
+        time_duration_t splay;
+        task::Group group;
+        task::Priority priority { task::Priority::NORMAL };
+        handle_t handle { 0 };
+        // Minute offset within the interval the task is aligned to
+        int anchor { 0 };
+        task::Alignment alignment { task::Alignment::NEXT_MINUTE };
+        std::uint32_t output_limit { task::constants::DEFAULT_OUTPUT_LIMIT };
+        // Times the task fires at instead of its interval, when set
+        cron::Expression cron;
     };
 
     bool operator < (const Task &lhs, const Task &rhs)
@@ -259,6 +441,26 @@ namespace chronos
         return lhs.time > rhs.time;
     }
 
+    /*
+     * Fixed retry_after, or with a backoff limit a "full jitter" delay:
+     * uniformly random between zero and retry_after doubled for every
+     * attempt made so far, capped at the limit. Tasks failing together
+     * then spread their retries instead of coming back in lockstep.
+     */
+    time_duration_t retry_delay(const Task &task)
+    {
+        const std::int64_t limit { task.backoff_limit.total_seconds() };
+        if (limit <= 0)
+            return task.retry_after;
+        constexpr int MAX_DOUBLINGS { 30 };
+        const auto doublings { std::min(task.attempts_count, MAX_DOUBLINGS) };
+        const std::int64_t base { task.retry_after.total_seconds() };
+        const auto cap { std::min(limit, base << doublings) };
+        thread_local std::mt19937_64 generator { std::random_device()() };
+        std::uniform_int_distribution<std::int64_t> distribution(0, cap);
+        return seconds_duration_t(distribution(generator));
+    }
+
     bool is_retry(const Task &task)
     {
         return task.attempts_count > 0;
@@ -269,24 +471,287 @@ namespace chronos
         return task.attempts_count < task.max_retries_count;
     }
 
+    time_duration_t splay_offset(const Task &task);
+
+    /*
+     * Intervals are added to the time as an integer, with calendar math
+     * only for months. A cron task keeps its splay offset from the
+     * minutes it fires at.
+     */
     void transit(Task &task)
     {
-        const auto time_transition {[&task] (const auto duration) {
-            return time::transit(task.time, duration); } };
-
-        task.time = std::visit(time_transition, task.interval);
+        const auto time { time::epoch::to_epoch(task.time) };
+        const auto time_transition {[time] (const auto &duration) {
+            return time::epoch::transit(time, duration); } };
+
+        if (cron::is_set(task.cron)) {
+            const auto offset { splay_offset(task) };
+            task.time = cron::next_fire(task.cron, task.time - offset)
+                + offset;
+        } else if (!time::epoch::is_special(time)) {
+            task.time = time::epoch::from_epoch(
+                    std::visit(time_transition, task.interval));
+        }
         task.attempts_count = 0;
     }
 
     Task create_retry(const Task &task)
     {
         Task retry_task(task);
-        retry_task.time += task.retry_after;
+        retry_task.time += retry_delay(task);
         retry_task.attempts_count += 1;
         return retry_task;
     }
 }
 
+namespace chronos::task::detail
+{
+    using count_t = std::int32_t;
+
+    struct IntervalCount
+    {
+        count_t operator () (const time_duration_t &interval) const
+        {
+            return interval.total_seconds();
+        }
+
+        count_t operator () (const days_duration_t &interval) const
+        {
+            return interval.days();
+        }
+
+        count_t operator () (const weeks_duration_t &interval) const
+        {
+            return interval.days() / time::constants::DAYS_IN_WEEK;
+        }
+
+        count_t operator () (const months_duration_t &interval) const
+        {
+            return interval.number_of_months().as_number();
+        }
+    };
+
+    // FNV-1a, stays the same across runs and builds unlike std::hash
+    std::uint64_t stable_hash(std::string_view text)
+    {
+        constexpr std::uint64_t OFFSET_BASIS { 14695981039346656037ull };
+        constexpr std::uint64_t PRIME { 1099511628211ull };
+        auto hash { OFFSET_BASIS };
+        for (const auto character : text) {
+            hash ^= static_cast<unsigned char>(character);
+            hash *= PRIME;
+        }
+        return hash;
+    }
+
+    duration_t make_interval(std::size_t unit, count_t count)
+    {
+        switch (unit)
+        {
+            case 0:
+                return duration_t(std::in_place_index<0>,
+                                  seconds_duration_t(count));
+            case 1:
+                return duration_t(std::in_place_index<1>, count);
+            case 2:
+                return duration_t(std::in_place_index<2>, count);
+            default:
+                return duration_t(std::in_place_index<3>, count);
+        }
+    }
+}
+
+namespace chronos
+{
+    /*
+     * Offset of the task within its splay window. It depends on the
+     * command only, so tasks aligned to the same boundary start spread
+     * over the window while each keeps its own offset for good.
+     */
+    time_duration_t splay_offset(const Task &task)
+    {
+        const auto window { task.splay.total_seconds() };
+        if (window <= 0)
+            return seconds_duration_t(0);
+        const auto hash { task::detail::stable_hash(task.command) };
+        return seconds_duration_t(hash % window);
+    }
+
+    /*
+     * First time of a task aligned as given and splayed by the offset.
+     * It is the nearest aligned time whose splayed time is still ahead,
+     * so a present inside the splay window still catches that time.
+     */
+    template <typename... AlignmentT>
+    time_t splayed_time_point(const time_duration_t &offset,
+                              const time_t &current_time,
+                              const AlignmentT&... alignment)
+    {
+        return time::closest_future_time_point(
+                alignment..., current_time - offset) + offset;
+    }
+
+    /*
+     * First time of the task as seen from the present, aligned the way
+     * it was built. The anchor is the minutes count of its aligned time.
+     */
+    time_t first_time(const Task &task, const time_t &current_time)
+    {
+        using namespace time::constants;
+        const auto offset { splay_offset(task) };
+        const auto anchor { task.anchor };
+        const auto minute { anchor % MINUTES_IN_HOUR };
+        const auto hour { anchor / MINUTES_IN_HOUR % HOURS_IN_DAY };
+        const auto day { anchor / (MINUTES_IN_HOUR * HOURS_IN_DAY) };
+        switch (task.alignment)
+        {
+            case task::Alignment::MINUTE_OF_HOUR:
+                return splayed_time_point(offset, current_time, anchor);
+            case task::Alignment::TIME_OF_DAY:
+                return splayed_time_point(offset, current_time,
+                                          time::DayTime { hour, minute });
+            case task::Alignment::TIME_OF_WEEK:
+                return splayed_time_point(offset, current_time,
+                        time::WeekTime { day, hour, minute });
+            case task::Alignment::TIME_OF_MONTH:
+                return splayed_time_point(offset, current_time,
+                        time::MonthTime { day, hour, minute });
+            case task::Alignment::CRON:
+                return splayed_time_point(offset, current_time, task.cron);
+            default:
+                return splayed_time_point(offset, current_time);
+        }
+    }
+}
+
+namespace chronos
+{
+    /*
+     * Task without its command and execution time, as kept in schedule
+     * storage. The interval is packed into its variant index and a count
+     * of that unit.
+     */
+    struct TaskRecord
+    {
+        std::int32_t interval_count { 0 };
+        std::int32_t anchor { 0 };
+        std::int32_t retry_after_seconds { 0 };
+        std::int32_t backoff_limit_seconds { 0 };
+        std::int32_t circuit_failures { 0 };
+        std::int32_t circuit_cool_down_seconds { 0 };
+        std::int32_t timeout_seconds { 0 };
+        std::int32_t splay_seconds { 0 };
+        std::int32_t group_max_concurrent { 0 };
+        float group_starts_per_second { 0 };
+        retry_count_t attempts_count { 0 };
+        retry_count_t max_retries_count { 0 };
+        std::uint32_t output_limit { 0 };
+        std::uint8_t interval_unit { 0 };
+        task::Priority priority { task::Priority::NORMAL };
+        cron::Expression cron;
+    };
+
+    /*
+     * Fills the record in place field by field, so bytes between fields
+     * keep what the record held, zeros when it is to be written out.
+     */
+    void fill_record(const Task &task, TaskRecord &record)
+    {
+        record.interval_count = std::visit(task::detail::IntervalCount(),
+                                           task.interval);
+        record.interval_unit = task.interval.index();
+        record.anchor = task.anchor;
+        record.retry_after_seconds = task.retry_after.total_seconds();
+        record.backoff_limit_seconds = task.backoff_limit.total_seconds();
+        record.circuit_failures = task.circuit_failures;
+        record.circuit_cool_down_seconds =
+                task.circuit_cool_down.total_seconds();
+        record.timeout_seconds = task.timeout.total_seconds();
+        record.splay_seconds = task.splay.total_seconds();
+        record.group_max_concurrent = task.group.max_concurrent;
+        record.group_starts_per_second = task.group.starts_per_second;
+        record.priority = task.priority;
+        record.attempts_count = task.attempts_count;
+        record.max_retries_count = task.max_retries_count;
+        record.output_limit = task.output_limit;
+        record.cron.minutes = task.cron.minutes;
+        record.cron.hours = task.cron.hours;
+        record.cron.month_days = task.cron.month_days;
+        record.cron.months = task.cron.months;
+        record.cron.week_days = task.cron.week_days;
+        record.cron.either_day = task.cron.either_day;
+    }
+
+    TaskRecord to_record(const Task &task)
+    {
+        TaskRecord record;
+        fill_record(task, record);
+        return record;
+    }
+
+    Task to_task(const TaskRecord &record, std::string_view command,
+                 std::string_view group, const time_t &time, handle_t handle)
+    {
+        Task task;
+        task.command = command;
+        task.group.name = group;
+        task.group.max_concurrent = record.group_max_concurrent;
+        task.group.starts_per_second = record.group_starts_per_second;
+        task.priority = record.priority;
+        task.time = time;
+        task.interval = task::detail::make_interval(record.interval_unit,
+                                                    record.interval_count);
+        task.anchor = record.anchor;
+        task.retry_after = seconds_duration_t(record.retry_after_seconds);
+        task.backoff_limit = seconds_duration_t(
+                record.backoff_limit_seconds);
+        task.circuit_failures = record.circuit_failures;
+        task.circuit_cool_down = seconds_duration_t(
+                record.circuit_cool_down_seconds);
+        task.timeout = seconds_duration_t(record.timeout_seconds);
+        task.splay = seconds_duration_t(record.splay_seconds);
+        task.attempts_count = record.attempts_count;
+        task.max_retries_count = record.max_retries_count;
+        task.output_limit = record.output_limit;
+        task.cron = record.cron;
+        task.handle = handle;
+        return task;
+    }
+
+    bool is_retry(const TaskRecord &record)
+    {
+        return record.attempts_count > 0;
+    }
+
+    bool same_definition(const TaskRecord &lhs, const TaskRecord &rhs)
+    {
+        return lhs.interval_unit == rhs.interval_unit
+            && lhs.interval_count == rhs.interval_count
+            && lhs.anchor == rhs.anchor
+            && lhs.max_retries_count == rhs.max_retries_count
+            && lhs.retry_after_seconds == rhs.retry_after_seconds
+            && lhs.backoff_limit_seconds == rhs.backoff_limit_seconds
+            && lhs.circuit_failures == rhs.circuit_failures
+            && lhs.circuit_cool_down_seconds == rhs.circuit_cool_down_seconds
+            && lhs.timeout_seconds == rhs.timeout_seconds
+            && lhs.splay_seconds == rhs.splay_seconds
+            && lhs.group_max_concurrent == rhs.group_max_concurrent
+            && lhs.group_starts_per_second == rhs.group_starts_per_second
+            && lhs.priority == rhs.priority
+            && lhs.output_limit == rhs.output_limit
+            && lhs.cron == rhs.cron;
+    }
+
+    std::size_t definition_hash(const TaskRecord &record)
+    {
+        const std::hash<std::int32_t> count_hash;
+        return count_hash(record.interval_count)
+            ^ (count_hash(record.anchor) << 1)
+            ^ (static_cast<std::size_t>(record.interval_unit) << 2)
+            ^ (static_cast<std::size_t>(record.cron.minutes) << 3);
+    }
+}
+
 namespace chronos
 {
     template <typename ClockT>
@@ -294,14 +759,16 @@ namespace chronos
     {
     public:
         using task_t = Task;
+        using clock_t = ClockT;
 
         TaskBuilder& createTask()
         {
             task = Task();
+            aligned = false;
             return *this;
         }
 
-        TaskBuilder& withCommand(const std::string &command)
+        TaskBuilder& withCommand(std::string_view command)
         {
             task.command = command;
             return *this;
@@ -341,31 +808,42 @@ namespace chronos
 
         TaskBuilder& atMonthDay(const time::MonthTime &time)
         {
-            task.time = time::closest_future_time_point<ClockT>(time);
+            alignTo(task::Alignment::TIME_OF_MONTH, time);
+            task.anchor = time::minutes_count(time);
             return *this;
         }
 
         TaskBuilder& atWeekDay(const time::WeekTime &time)
         {
-            task.time = time::closest_future_time_point<ClockT>(time);
+            alignTo(task::Alignment::TIME_OF_WEEK, time);
+            task.anchor = time::minutes_count(time);
             return *this;
         }
 
         TaskBuilder& atHour(const time::DayTime &time)
         {
-            task.time = time::closest_future_time_point<ClockT>(time);
+            alignTo(task::Alignment::TIME_OF_DAY, time);
+            task.anchor = time::minutes_count(time);
             return *this;
         }
 
         TaskBuilder& atMinute(time::hour_time_t time)
         {
-            task.time = time::closest_future_time_point<ClockT>(time);
+            alignTo(task::Alignment::MINUTE_OF_HOUR, time);
+            task.anchor = time;
             return *this;
         }
 
         TaskBuilder& atMinute()
         {
-            task.time = time::closest_future_time_point<ClockT>();
+            alignTo(task::Alignment::NEXT_MINUTE);
+            return *this;
+        }
+
+        TaskBuilder& onCron(const cron::Expression &expression)
+        {
+            task.cron = expression;
+            alignTo(task::Alignment::CRON, expression);
             return *this;
         }
 
@@ -381,12 +859,71 @@ namespace chronos
             return *this;
         }
 
+        TaskBuilder& backoffUpTo(int seconds)
+        {
+            task.backoff_limit = seconds_duration_t(seconds);
+            return *this;
+        }
+
+        TaskBuilder& breakCircuitAfter(int failures, int cool_down_seconds)
+        {
+            task.circuit_failures = failures;
+            task.circuit_cool_down = seconds_duration_t(cool_down_seconds);
+            return *this;
+        }
+
+        TaskBuilder& timeoutAfter(int seconds)
+        {
+            task.timeout = seconds_duration_t(seconds);
+            return *this;
+        }
+
+        TaskBuilder& splayWithin(int seconds)
+        {
+            task.splay = seconds_duration_t(seconds);
+            return *this;
+        }
+
+        TaskBuilder& inGroup(std::string_view name, int max_concurrent,
+                             double starts_per_second)
+        {
+            task.group = { std::string(name), max_concurrent,
+                           starts_per_second };
+            return *this;
+        }
+
+        TaskBuilder& withPriority(int level)
+        {
+            task.priority = static_cast<task::Priority>(level);
+            return *this;
+        }
+
+        TaskBuilder& captureBytes(std::uint32_t bytes)
+        {
+            task.output_limit = bytes;
+            return *this;
+        }
+
         Task build() const
         {
-            return task;
+            Task result { task };
+            result.time = aligned
+                ? first_time(result, ClockT::local_time())
+                : result.time + splay_offset(result);
+            return result;
         }
 
     private:
+        // The splay is known only once built, so the time is found again
+        template <typename... AlignmentT>
+        void alignTo(task::Alignment alignment, const AlignmentT&... spec)
+        {
+            task.alignment = alignment;
+            task.time = time::closest_future_time_point<ClockT>(spec...);
+            aligned = true;
+        }
+
         Task task;
+        bool aligned { false };
     };
 }
\ No newline at end of file
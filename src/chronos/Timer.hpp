@@ -7,26 +7,45 @@
 
 namespace chronos
 {
+    /*
+     * Waits for a duration, or until interrupted, against a deadline on
+     * the monotonic clock. Spurious wake ups and changes of the wall
+     * clock neither stretch nor cut the wait, and it is as precise as
+     * the duration, to the microsecond.
+     */
     class Timer
     {
     public:
         using duration_t = boost::posix_time::time_duration;
-        using seconds_t = std::chrono::seconds;
+        using clock_t = std::chrono::steady_clock;
+        using microseconds_t = std::chrono::microseconds;
 
         void wait(const duration_t &duration)
         {
-            std::mutex mutex;
             std::unique_lock<std::mutex> lock(mutex);
-            const auto seconds_wait { duration.total_seconds() };
-            interrupted.wait_for(lock, seconds_t(seconds_wait));
+            const auto is_interrupted { [this] () { return interrupted; } };
+            if (duration.is_pos_infinity()) {
+                interruption.wait(lock, is_interrupted);
+            } else if (!duration.is_special() && !duration.is_negative()) {
+                const auto deadline { clock_t::now()
+                    + microseconds_t(duration.total_microseconds()) };
+                interruption.wait_until(lock, deadline, is_interrupted);
+            }
+            interrupted = false;
         }
 
         void interrupt()
         {
-            interrupted.notify_one();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                interrupted = true;
+            }
+            interruption.notify_one();
         }
 
     private:
-        std::condition_variable interrupted;
+        std::mutex mutex;
+        std::condition_variable interruption;
+        bool interrupted { false };
     };
 }
@@ -1,6 +1,14 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
 #include <random>
+#include <string_view>
+#include <thread>
 #include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "chronos/Filesystem.hpp"
 
 
 namespace test::system
@@ -9,6 +17,9 @@ namespace test::system
     {
         bool success;
         std::string message;
+        std::size_t dropped_bytes { 0 };
+        std::size_t dropped_at { 0 };
+        bool timed_out { false };
     };
 }
 
@@ -35,11 +46,29 @@ namespace test
         }
     };
 
+    // Steady clock standing still until a test moves it
+    struct SteadyClock
+    {
+        using duration = std::chrono::steady_clock::duration;
+        using rep = duration::rep;
+        using period = duration::period;
+        using time_point = std::chrono::time_point<SteadyClock>;
+        static constexpr bool is_steady { true };
+
+        inline static time_point time {};
+
+        static time_point now()
+        {
+            return time;
+        }
+    };
+
     struct FailingExecution
     {
         using response_t = system::Response;
 
-        response_t operator() (const std::string&)
+        template <typename TaskT>
+        response_t operator() (const TaskT&)
         {
             return { .success = false };
         }
@@ -50,7 +79,8 @@ namespace test
     public:
         using response_t = system::Response;
 
-        response_t operator() (const std::string&)
+        template <typename TaskT>
+        response_t operator() (const TaskT&)
         {
             const bool success(distribution(generator));
             return { .success = success };
@@ -62,6 +92,81 @@ namespace test
             std::uniform_int_distribution(0, 1) };
     };
 
+    // Holds "block" commands until released, lets others through at once
+    struct BlockingExecution
+    {
+        using response_t = system::Response;
+
+        inline static std::mutex mutex;
+        inline static std::condition_variable release_signal;
+        inline static bool released { false };
+        inline static std::atomic<int> executed_count { 0 };
+
+        template <typename TaskT>
+        response_t operator() (const TaskT &task)
+        {
+            if (task.command == "block") {
+                std::unique_lock<std::mutex> lock(mutex);
+                release_signal.wait(lock, [] () { return released; });
+            }
+            ++executed_count;
+            return { .success = true };
+        }
+
+        static void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                released = true;
+            }
+            release_signal.notify_all();
+        }
+    };
+
+    // Copies the output out of a response that only views it
+    template <typename ResponseT>
+    system::Response keep(const ResponseT &response)
+    {
+        return { .success = response.success,
+                 .message = std::string(response.message),
+                 .dropped_bytes = response.dropped_bytes,
+                 .dropped_at = response.dropped_at,
+                 .timed_out = response.timed_out };
+    }
+
+    std_filesystem::path make_temporary_directory()
+    {
+        std::string pattern {
+            (std_filesystem::temp_directory_path() / "chronos-XXXXXX") };
+        return mkdtemp(pattern.data());
+    }
+
+    // Parser counting the inputs it parsed
+    template <typename ParserT>
+    struct CountingParser
+    {
+        using result_t = typename ParserT::result_t;
+        using clock_t = typename ParserT::clock_t;
+
+        result_t parse(std::string_view input)
+        {
+            ++parsed;
+            return parser.parse(input);
+        }
+
+        static inline int parsed { 0 };
+        ParserT parser;
+    };
+
+    template <typename PredicateT>
+    bool eventually(PredicateT predicate)
+    {
+        using namespace std::chrono_literals;
+        for (int i = 0; i < 500 && !predicate(); ++i)
+            std::this_thread::sleep_for(10ms);
+        return predicate();
+    }
+
     template <typename ScheduleT>
     std::string pop_command(ScheduleT &schedule)
     {
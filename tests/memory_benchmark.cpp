@@ -0,0 +1,86 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "fmt/core.h"
+#include "chronos/Schedule.hpp"
+#include "chronos/Task.hpp"
+#include "TestUtils.hpp"
+
+
+namespace benchmark
+{
+    using task_t = chronos::Task;
+    using schedule_t = chronos::Schedule<task_t, test::Clock>;
+    using plain_queue_t = std::priority_queue<task_t, std::vector<task_t> >;
+
+    constexpr int TASKS_COUNT { 1000000 };
+    constexpr int DISTINCT_COMMANDS_COUNT { 1000 };
+
+    long resident_memory_kb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.rfind("VmRSS:", 0) == 0)
+                return std::stol(line.substr(6));
+        return 0;
+    }
+
+    task_t make_task(int number, int distinct_commands)
+    {
+        using namespace boost::posix_time;
+        task_t task;
+        task.command = fmt::format(
+                "/usr/local/bin/sync-job --shard {} --verbose",
+                number % distinct_commands);
+        task.time = test::Clock::time + seconds(number % 86400);
+        task.interval = hours(1);
+        task.max_retries_count = 3;
+        task.retry_after = seconds(30);
+        return task;
+    }
+
+    template <typename ContainerT>
+    void measure(const std::string &name, int distinct_commands)
+    {
+        std::fflush(stdout);
+        if (fork()) {
+            wait(nullptr);
+            return;
+        }
+        const auto before { resident_memory_kb() };
+        ContainerT container;
+        for (int i = 0; i < TASKS_COUNT; ++i) {
+            const auto task { make_task(i, distinct_commands) };
+            if constexpr (std::is_same_v<ContainerT, plain_queue_t>)
+                container.push(task);
+            else
+                container.add(task);
+        }
+        const auto used { resident_memory_kb() - before };
+        fmt::print("{:<40} {:>8} KB  {:>6.1f} B/task\n",
+                   name, used, used * 1024.0 / TASKS_COUNT);
+        std::exit(EXIT_SUCCESS);
+    }
+}
+
+int main()
+{
+    using namespace benchmark;
+    fmt::print("Resident memory of {} queued tasks\n", TASKS_COUNT);
+    measure<plain_queue_t>("priority_queue<Task>, unique commands",
+                           TASKS_COUNT);
+    measure<schedule_t>("Schedule, unique commands", TASKS_COUNT);
+    measure<plain_queue_t>(fmt::format(
+            "priority_queue<Task>, {} commands", DISTINCT_COMMANDS_COUNT),
+            DISTINCT_COMMANDS_COUNT);
+    measure<schedule_t>(fmt::format(
+            "Schedule, {} commands", DISTINCT_COMMANDS_COUNT),
+            DISTINCT_COMMANDS_COUNT);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <chrono>
+#include <string>
+#include "fmt/core.h"
+#include "chronos/Cache.hpp"
+#include "chronos/Parser.hpp"
+#include "chronos/Task.hpp"
+#include "TestUtils.hpp"
+
+
+namespace benchmark
+{
+    using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
+    using milliseconds_t = std::chrono::duration<double, std::milli>;
+
+    constexpr int LINES_COUNT { 100000 };
+    constexpr int REPETITIONS { 5 };
+
+    std::string make_content(int lines)
+    {
+        std::string content;
+        for (int i = 0; i < lines; ++i)
+            switch (i % 5) {
+                case 0:
+                    content += fmt::format("Run \"/usr/local/bin/job"
+                            " --shard {}\" every 5 minutes;\n", i);
+                    break;
+                case 1:
+                    content += fmt::format("Run \"backup {}\" every day"
+                            " at 3:15 retry after 5 minutes 3 times"
+                            " timeout 30 minutes;\n", i);
+                    break;
+                case 2:
+                    content += fmt::format("Run \"report {}\" every 2 weeks"
+                            " at friday 17:30 priority high"
+                            " group \"reports\";\n", i);
+                    break;
+                case 3:
+                    content += fmt::format("Run \"rotate {}\" every month"
+                            " at 1 0:05 splay 10 minutes"
+                            " capture 4 kilobytes;\n", i);
+                    break;
+                default:
+                    content += fmt::format("Run \"sync {}\" every hour at 30"
+                            " retry with backoff 10 seconds up to 10 minutes"
+                            " 5 times;\n", i);
+                    break;
+            }
+        return content;
+    }
+
+    // Best of several runs, in milliseconds
+    template <typename ParseT>
+    double measure(ParseT parse)
+    {
+        double best { 0 };
+        for (int i = 0; i < REPETITIONS; ++i) {
+            const auto start { std::chrono::steady_clock::now() };
+            parse();
+            const milliseconds_t elapsed {
+                std::chrono::steady_clock::now() - start };
+            if (!i || elapsed.count() < best)
+                best = elapsed.count();
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    using namespace benchmark;
+    const auto content { make_content(LINES_COUNT) };
+    fmt::print("Parsing {} lines, {:.1f} MB\n",
+               LINES_COUNT, content.size() / 1e6);
+
+    std::size_t entries_count { 0 };
+    const auto entries_time { measure([&] () {
+        entries_count = chronos::parser::parse_entries(content).size(); }) };
+    fmt::print("{:<24} {:>8.1f} ms  {:>7.0f} MB/s\n", "Entries",
+               entries_time, content.size() / entries_time / 1e3);
+
+    parser_t parser;
+    std::size_t tasks_count { 0 };
+    const auto tasks_time { measure([&] () {
+        tasks_count = parser.parse(content).size(); }) };
+    fmt::print("{:<24} {:>8.1f} ms  {:>7.0f} MB/s\n", "Tasks",
+               tasks_time, content.size() / tasks_time / 1e3);
+
+    using task_builder_t = chronos::TaskBuilder<test::Clock>;
+    const auto image { chronos::cache::compile<task_builder_t>(content) };
+    std::size_t loaded_count { 0 };
+    const auto loaded_time { measure([&] () {
+        loaded_count = chronos::cache::load<test::Clock>(
+                image, content)->size(); }) };
+    fmt::print("{:<24} {:>8.1f} ms  {:>7.0f} MB/s\n", "Compiled tasks",
+               loaded_time, content.size() / loaded_time / 1e3);
+
+    return entries_count == LINES_COUNT && tasks_count == LINES_COUNT
+        && loaded_count == LINES_COUNT ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,11 +1,17 @@
 #define CATCH_CONFIG_MAIN
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "catch2/catch.hpp"
+#include "chronos/Cache.hpp"
+#include "chronos/Coordinator.hpp"
 #include "chronos/Dispatcher.hpp"
+#include "chronos/Execution.hpp"
+#include "chronos/Filesystem.hpp"
 #include "chronos/Parser.hpp"
+#include "chronos/Reactor.hpp"
 #include "chronos/Schedule.hpp"
 #include "chronos/System.hpp"
 #include "chronos/Task.hpp"
+#include "chronos/Timer.hpp"
 #include "TestUtils.hpp"
 
 
@@ -18,6 +24,15 @@ namespace chronos
 namespace test
 {
     using artificial_clock_t = test::Clock;
+    using wheel_schedule_t = chronos::Schedule<chronos::Task,
+        artificial_clock_t, chronos::schedule::TimingWheel>;
+
+    chronos::Task command_task(const std::string &command)
+    {
+        chronos::Task task;
+        task.command = command;
+        return task;
+    }
 }
 
 SCENARIO ("Scheduled tasks are sorted chronologically", "[unit]")
@@ -64,6 +79,172 @@ SCENARIO ("Scheduled tasks are sorted chronologically", "[unit]")
     }
 }
 
+SCENARIO ("Timing wheel withdraws tasks in the same order as heap",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+
+    test::artificial_clock_t::time = ptime(date(2021, Mar, 1), hours(8));
+
+    GIVEN ("Heap and timing wheel schedules filled with the same tasks"
+           " spread from seconds to months, some of them overdue")
+    {
+        test::wheel_schedule_t wheel;
+        chronos::Schedule<chronos::Task, test::artificial_clock_t> heap;
+
+        std::default_random_engine generator;
+        std::uniform_int_distribution<int> offsets(-3600, 90 * 24 * 3600);
+        for (int i = 0; i < 2000; ++i) {
+            chronos::Task task;
+            task.command = std::to_string(i);
+            task.time = test::artificial_clock_t::time
+                    + seconds(offsets(generator) / (1 + i % 4 * 60));
+            wheel.add(task);
+            heap.add(task);
+        }
+
+        WHEN ("Tasks are withdrawn while new ones keep arriving")
+        {
+            bool same_order { true };
+            for (int i = 0; i < 3000; ++i) {
+                const auto from_wheel { wheel.withdrawNextTask() };
+                const auto from_heap { heap.withdrawNextTask() };
+                same_order = same_order && from_wheel.time == from_heap.time;
+                if (i % 2) {
+                    auto task { from_heap };
+                    task.time += minutes(i % 120);
+                    wheel.add(task);
+                    heap.add(task);
+                }
+            }
+
+            THEN ("Execution times are withdrawn in the same order")
+            {
+                REQUIRE(same_order);
+                REQUIRE(wheel.isEmpty() == heap.isEmpty());
+            }
+        }
+    }
+}
+
+SCENARIO ("Timing wheel schedule cancels, updates and reloads tasks",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+
+    test::artificial_clock_t::time = ptime(date(2021, Mar, 1), hours(8));
+
+    GIVEN ("A timing wheel schedule with tasks a minute, an hour"
+           " and a day ahead")
+    {
+        test::wheel_schedule_t wheel;
+        std::vector<chronos::Task> tasks;
+        std::vector<chronos::handle_t> handles;
+        for (const auto &offset :
+                { minutes(1), minutes(60), minutes(24 * 60) }) {
+            auto task { test::command_task(std::to_string(tasks.size())) };
+            task.time = test::artificial_clock_t::time + offset;
+            tasks.push_back(task);
+            handles.push_back(wheel.add(task));
+        }
+
+        WHEN ("The first task is cancelled and the last one moved"
+              " before the second, then moved back and forth again")
+        {
+            const bool cancelled { wheel.cancel(handles[0]) };
+            wheel.update(handles[2], test::artificial_clock_t::time
+                                     + minutes(30));
+            wheel.update(handles[2], test::artificial_clock_t::time
+                                     + hours(24));
+            const bool updated { wheel.update(handles[2],
+                    test::artificial_clock_t::time + minutes(30)) };
+
+            THEN ("The moved task comes first and only once")
+            {
+                REQUIRE(cancelled);
+                REQUIRE(updated);
+                REQUIRE(!wheel.find(handles[0]));
+                REQUIRE(wheel.find(handles[2])->time
+                        == test::artificial_clock_t::time + minutes(30));
+                REQUIRE(test::pop_command(wheel) == "2");
+                REQUIRE(test::pop_command(wheel) == "1");
+                REQUIRE(wheel.isEmpty());
+            }
+        }
+
+        WHEN ("The schedule is reloaded without the second task")
+        {
+            const auto summary { wheel.reload({ tasks[0], tasks[2] }) };
+
+            THEN ("The vanished task is removed and the rest kept in order")
+            {
+                REQUIRE(summary.kept == 2);
+                REQUIRE(summary.removed == 1);
+                REQUIRE(test::pop_command(wheel) == "0");
+                REQUIRE(test::pop_command(wheel) == "2");
+                REQUIRE(wheel.isEmpty());
+            }
+        }
+    }
+}
+
+SCENARIO ("Queued tasks are cancelled and updated by their handles",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+
+    GIVEN ("A schedule with three tasks on consecutive days")
+    {
+        chronos::schedule_t schedule;
+        std::vector<chronos::handle_t> handles;
+        for (const auto &command : { "first", "second", "third" }) {
+            chronos::Task task;
+            task.command = command;
+            task.time = ptime(date(2020, Jan, 1), hours(1))
+                    + days(handles.size());
+            handles.push_back(schedule.add(task));
+        }
+
+        WHEN ("The first task is cancelled and the third one moved"
+              " before the second")
+        {
+            const bool cancelled { schedule.cancel(handles[0]) };
+            const bool updated { schedule.update(handles[2],
+                    ptime(date(2020, Jan, 1), hours(12))) };
+
+            THEN ("Cancelled task is gone and the rest is reordered")
+            {
+                REQUIRE(cancelled);
+                REQUIRE(updated);
+                REQUIRE(!schedule.find(handles[0]));
+                REQUIRE(schedule.find(handles[2])->command == "third");
+                REQUIRE(test::pop_command(schedule) == "third");
+                REQUIRE(test::pop_command(schedule) == "second");
+                REQUIRE(schedule.isEmpty());
+                REQUIRE(!schedule.cancel(handles[0]));
+            }
+        }
+
+        WHEN ("The first task is withdrawn and rescheduled")
+        {
+            auto task { schedule.withdrawNextTask() };
+            task.interval = days(7);
+            schedule.reschedule(task);
+
+            THEN ("It is still reachable by the same handle")
+            {
+                const auto rescheduled { schedule.find(handles[0]) };
+                REQUIRE(rescheduled);
+                REQUIRE(rescheduled->time
+                        == ptime(date(2020, Jan, 8), hours(1)));
+            }
+        }
+    }
+}
+
 SCENARIO ("Time transition is carried correctly", "[unit]")
 {
     GIVEN ("A task with certain execution time and interval")
@@ -176,125 +357,1559 @@ SCENARIO ("Failed job is retried exact number of times", "[unit]")
     }
 }
 
-SCENARIO ("Entry with retry parameters is parsed correctly", "[unit]")
+SCENARIO ("Retries back off with jitter and stop while circuit is open",
+          "[unit]")
 {
-    using parser_t = chronos::parser::parser;
-    using boost::spirit::ascii::space;
-    using chronos::parser::strct::TaskEntry;
-    parser_t parser;
+    using namespace boost::posix_time;
+
+    GIVEN ("Entry retrying with backoff")
+    {
+        using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
 
-    TaskEntry output;
+        parser_t parser;
+        const auto task { parser.parse(
+                "Run \"sync\" every hour"
+                " retry with backoff 10 seconds up to 10 minutes 5 times;")
+                .front() };
 
-    GIVEN ("Entry with retry time and count")
+        WHEN ("Retry delays are drawn for successive attempts")
+        {
+            std::vector<time_duration> delays[3];
+            const int attempts[3] { 0, 3, 10 };
+            for (int i = 0; i < 3; ++i) {
+                auto attempt { task };
+                attempt.attempts_count = attempts[i];
+                for (int sample = 0; sample < 200; ++sample)
+                    delays[i].push_back(chronos::retry_delay(attempt));
+            }
+
+            THEN ("They spread below a cap doubling up to the limit")
+            {
+                REQUIRE(task.retry_after == seconds(10));
+                REQUIRE(task.backoff_limit == minutes(10));
+                REQUIRE(task.max_retries_count == 5);
+                const time_duration caps[3] {
+                    seconds(10), seconds(80), minutes(10) };
+                for (int i = 0; i < 3; ++i) {
+                    const auto [shortest, longest] { std::minmax_element(
+                            begin(delays[i]), end(delays[i])) };
+                    REQUIRE(*shortest >= seconds(0));
+                    REQUIRE(*longest <= caps[i]);
+                    REQUIRE(*shortest < *longest);
+                }
+            }
+        }
+    }
+
+    GIVEN ("Circuit breaker on a test clock and entries with and without"
+           " a circuit part")
     {
-        const std::string entry {
-            "Run \"test:test\" every 3 hours retry after 5 seconds "
-            "3 times;" };
+        using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
+        using std::chrono::minutes;
+
+        chronos::dispatcher::CircuitBreaker<test::SteadyClock> breaker;
+        const auto tasks { parser_t().parse(
+                "Run \"flaky\" every hour retry after a minute"
+                " circuit after 3 failures for 30 minutes;"
+                "Run \"plain\" every hour retry after a minute;") };
+        const auto &flaky { tasks[0] };
+        const auto &plain { tasks[1] };
+
+        WHEN ("Both commands fail 3 times in a row")
+        {
+            for (int i = 0; i < 3; ++i) {
+                breaker.record(flaky, false);
+                breaker.record(plain, false);
+            }
 
-        WHEN ("Entry is parsed")
+            THEN ("Only the one with its own threshold has an open circuit")
+            {
+                REQUIRE(flaky.circuit_failures == 3);
+                REQUIRE(flaky.circuit_cool_down == seconds(30 * 60));
+                REQUIRE(!breaker.allowsRetry(flaky));
+                REQUIRE(breaker.allowsRetry(plain));
+            }
+
+            AND_THEN ("It half opens after its own cool-down")
+            {
+                test::SteadyClock::time += minutes(29);
+                REQUIRE(!breaker.allowsRetry(flaky));
+                test::SteadyClock::time += minutes(1);
+                REQUIRE(breaker.allowsRetry(flaky));
+                breaker.record(flaky, false);
+                REQUIRE(!breaker.allowsRetry(flaky));
+                breaker.record(flaky, true);
+                REQUIRE(breaker.allowsRetry(flaky));
+            }
+        }
+
+        WHEN ("The other command fails as often as the default threshold")
         {
-            std::string::const_iterator iter { entry.begin() };
-            std::string::const_iterator end { entry.end() };
-            const bool result {
-                phrase_parse(iter, end, parser, space, output) };
+            for (int i = 0; i < 5; ++i)
+                breaker.record(plain, false);
 
-            THEN ("Parsing is successful")
+            THEN ("It waits for the default cool-down")
             {
-                const bool success { result && iter == end };
-                REQUIRE(success);
+                REQUIRE(!breaker.allowsRetry(plain));
+                test::SteadyClock::time += minutes(9);
+                REQUIRE(!breaker.allowsRetry(plain));
+                test::SteadyClock::time += minutes(1);
+                REQUIRE(breaker.allowsRetry(plain));
             }
         }
     }
 }
 
-SCENARIO ("Entry with specified time is parsed correctly", "[unit]")
+SCENARIO ("Task is restored unchanged from schedule storage", "[unit]")
 {
-    using parser_t = chronos::parser::parser;
-    using boost::spirit::ascii::space;
-    using chronos::parser::strct::TaskEntry;
-    parser_t parser;
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
 
-    TaskEntry output;
+    GIVEN ("A monthly task with retries and a task sharing its command")
+    {
+        chronos::schedule_t schedule;
+        chronos::Task task;
+        task.command = "./backup --full";
+        task.time = ptime(date(2021, Jan, 31), hours(2));
+        task.interval = months(1);
+        task.anchor = 31 * 24 * 60 + 2 * 60;
+        task.max_retries_count = 2;
+        task.retry_after = minutes(5);
+        auto twin { task };
+        twin.time += hours(1);
+        schedule.add(task);
+        const auto twin_handle { schedule.add(twin) };
+
+        WHEN ("The task is withdrawn and its twin cancelled")
+        {
+            const auto withdrawn { schedule.withdrawNextTask() };
+            schedule.cancel(twin_handle);
 
-    GIVEN ("Entry with 'at' part")
+            THEN ("All of its fields survive the round trip")
+            {
+                REQUIRE(withdrawn.command == task.command);
+                REQUIRE(withdrawn.time == task.time);
+                REQUIRE(withdrawn.interval == task.interval);
+                REQUIRE(withdrawn.anchor == task.anchor);
+                REQUIRE(withdrawn.max_retries_count == 2);
+                REQUIRE(withdrawn.retry_after == minutes(5));
+                REQUIRE(schedule.isEmpty());
+            }
+        }
+
+        WHEN ("The task is cancelled while withdrawn")
+        {
+            auto withdrawn { schedule.withdrawNextTask() };
+            schedule.cancel(withdrawn.handle);
+            schedule.reschedule(withdrawn);
+
+            THEN ("Rescheduling does not bring it back")
+            {
+                REQUIRE(test::pop_command(schedule) == task.command);
+                REQUIRE(schedule.isEmpty());
+            }
+        }
+    }
+}
+
+SCENARIO ("Reload keeps unchanged tasks and replaces only the edited ones",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+    using task_builder_t = chronos::TaskBuilder<test::artificial_clock_t>;
+    using dispatcher_t = chronos::Dispatcher<chronos::schedule_t,
+        test::FailingExecution>;
+
+    test::artificial_clock_t::time = ptime(date(2021, Mar, 1), hours(8));
+    task_builder_t task_builder;
+    const auto hourly_task { [&task_builder] (const std::string &command,
+                                              int minute) {
+        return task_builder
+            .createTask()
+            .withCommand(command)
+            .everyHoursCount(1)
+            .atMinute(minute)
+            .retryTimes(2)
+            .retryAfter(60)
+            .build(); } };
+
+    GIVEN ("A schedule with two hourly tasks, one of them already retried")
     {
-        const std::string entry {
-                "Run \"./program -i --param\" every month at 2 12:30"
-                " retry after 5 seconds 3 times;" };
+        auto schedule { std::make_shared<chronos::schedule_t>() };
+        dispatcher_t dispatcher(schedule);
+        schedule->add(hourly_task("kept", 30));
+        schedule->add(hourly_task("removed", 45));
+        dispatcher.handleNextTask();
 
-        WHEN ("Entry is parsed")
+        WHEN ("The schedule is reloaded with the kept task and a new one")
         {
-            std::string::const_iterator iter { entry.begin() };
-            std::string::const_iterator end { entry.end() };
-            const bool result {
-                    phrase_parse(iter, end, parser, space, output) };
+            const auto summary { dispatcher.reload(
+                    { hourly_task("added", 15), hourly_task("kept", 30) }) };
 
-            THEN ("Parsing is successful")
+            THEN ("Only the difference is applied to the queue")
+            {
+                REQUIRE(summary.kept == 1);
+                REQUIRE(summary.added == 1);
+                REQUIRE(summary.removed == 1);
+
+                std::multiset<std::string> commands;
+                while (!schedule->isEmpty()) {
+                    const auto task { schedule->withdrawNextTask() };
+                    commands.insert(task.command
+                            + (chronos::is_retry(task) ? " retry" : ""));
+                }
+                REQUIRE(commands == std::multiset<std::string> {
+                    "added", "kept", "kept retry" });
+            }
+        }
+
+        WHEN ("The kept task is redefined to run at another minute")
+        {
+            const auto summary { dispatcher.reload(
+                    { hourly_task("kept", 40) }) };
+
+            THEN ("It is replaced together with its pending retry")
             {
-                const bool success { result && iter == end };
-                REQUIRE(success);
+                REQUIRE(summary.added == 1);
+                REQUIRE(summary.removed == 3);
+                REQUIRE(schedule->withdrawNextTask().time
+                        == ptime(date(2021, Mar, 1), hours(8)
+                                 + minutes(40)));
+                REQUIRE(schedule->isEmpty());
             }
         }
     }
 }
 
-SCENARIO ("Entry with specified hour and singular retry time unit"
-         " is parsed correctly", "[unit]")
+SCENARIO ("All due tasks are handled in a single batch", "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+    using dispatcher_t = chronos::Dispatcher<chronos::schedule_t,
+        test::FailingExecution>;
+
+    GIVEN ("Five daily tasks due at the same minute and one due later")
+    {
+        const ptime minute { date(2020, Jul, 1), hours(12) };
+        auto schedule { std::make_shared<chronos::schedule_t>() };
+        dispatcher_t dispatcher(schedule);
+        for (int i = 0; i < 5; ++i) {
+            chronos::Task task;
+            task.command = "due";
+            task.time = minute;
+            task.interval = days(1);
+            schedule->add(task);
+        }
+        chronos::Task later;
+        later.command = "later";
+        later.time = minute + seconds(1);
+        later.interval = days(1);
+        schedule->add(later);
+
+        WHEN ("Due tasks are withdrawn at that minute")
+        {
+            const auto due { schedule->withdrawDueTasks(minute) };
+
+            THEN ("Exactly the five due tasks are withdrawn")
+            {
+                REQUIRE(due.size() == 5);
+                REQUIRE(test::pop_command(*schedule) == "later");
+            }
+        }
+
+        WHEN ("Dispatcher handles due tasks after they passed")
+        {
+            dispatcher.handleDueTasks();
+
+            THEN ("Every task ran once and the daily ones were rescheduled")
+            {
+                REQUIRE(schedule->withdrawDueTasks(minute + hours(1)).empty());
+                REQUIRE(schedule->withdrawDueTasks(minute + days(1)).size()
+                        == 5);
+            }
+        }
+    }
+}
+
+SCENARIO ("Long running task does not hold back other due tasks",
+          "[unit]")
 {
-    using parser_t = chronos::parser::parser;
-    using boost::spirit::ascii::space;
-    using chronos::parser::strct::TaskEntry;
-    parser_t parser;
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+    using schedule_t = chronos::Schedule<chronos::Task,
+        test::artificial_clock_t>;
+    using dispatcher_t = chronos::AsyncDispatcher<schedule_t,
+        chronos::AsyncExecution<test::BlockingExecution> >;
 
-    TaskEntry output;
+    test::artificial_clock_t::time = ptime(date(2020, Jul, 1), hours(12));
 
-    GIVEN("Entry with 'at' part")
+    GIVEN ("A blocking task and a quick task due at the same time")
     {
-        const std::string entry {
-                "Run \"./program -i --param\" every day at 23:15"
-                " retry after a minute;" };
+        auto schedule { std::make_shared<schedule_t>() };
+        auto dispatcher { std::make_unique<dispatcher_t>(schedule, 2) };
+        std::atomic<int> wake_ups_count { 0 };
+        dispatcher->setWakeUp([&wake_ups_count] () { ++wake_ups_count; });
 
-        WHEN ("Entry is parsed")
+        chronos::Task task;
+        task.time = test::artificial_clock_t::time;
+        task.interval = days(1);
+        task.command = "block";
+        const auto blocking_handle { schedule->add(task) };
+        task.command = "quick";
+        const auto quick_handle { schedule->add(task) };
+
+        WHEN ("Due tasks are handed over to workers")
         {
-            std::string::const_iterator iter { entry.begin() };
-            std::string::const_iterator end { entry.end() };
-            const bool result {
-                    phrase_parse(iter, end, parser, space, output) };
+            dispatcher->handleDueTasks();
 
-            THEN ("Parsing is successful")
+            THEN ("Quick task completes and is rescheduled"
+                  " while the blocking one still runs")
             {
-                const bool success { result && iter == end };
-                REQUIRE(success);
+                REQUIRE(test::eventually([&] () {
+                    return wake_ups_count == 1; }));
+                REQUIRE(test::BlockingExecution::executed_count == 1);
+                REQUIRE(dispatcher->timeToNextTask() == hours(24));
+                REQUIRE(schedule->find(quick_handle));
+                REQUIRE(!schedule->find(blocking_handle));
+
+                test::BlockingExecution::release();
+                REQUIRE(test::eventually([&] () {
+                    return wake_ups_count == 2; }));
+                REQUIRE(schedule->find(blocking_handle));
             }
         }
     }
 }
 
-SCENARIO ("Entry is parsed correctly when minute part is 00", "[unit]")
+SCENARIO ("Reloaded tasks are dispatched by the running coordinator",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+    using schedule_t = chronos::Schedule<chronos::Task,
+        test::artificial_clock_t>;
+    using dispatcher_t = chronos::AsyncDispatcher<schedule_t,
+        chronos::AsyncExecution<test::BlockingExecution> >;
+    using coordinator_t = chronos::CoordinatorThread<dispatcher_t,
+        chronos::Timer>;
+
+    test::artificial_clock_t::time = ptime(date(2020, Jul, 1), hours(12));
+
+    GIVEN ("Coordinator waiting on an empty schedule")
+    {
+        auto schedule { std::make_shared<schedule_t>() };
+        auto dispatcher { std::make_shared<dispatcher_t>(schedule, 1) };
+        coordinator_t coordinator(dispatcher);
+        const int executed_before { test::BlockingExecution::executed_count };
+
+        WHEN ("Schedule is reloaded with a task due at once")
+        {
+            chronos::Task task;
+            task.time = test::artificial_clock_t::time;
+            task.interval = days(1);
+            task.command = "quick";
+            const auto summary { dispatcher->reload({ task }) };
+
+            THEN ("Coordinator wakes up and dispatches it without restart")
+            {
+                REQUIRE(summary.added == 1);
+                REQUIRE(test::eventually([&] () {
+                    return test::BlockingExecution::executed_count
+                        == executed_before + 1; }));
+            }
+        }
+
+        coordinator.terminate();
+    }
+}
+
+SCENARIO ("Simple commands are spawned without the shell", "[unit]")
 {
-    using parser_t = chronos::parser::parser;
-    using boost::spirit::ascii::space;
-    using chronos::parser::strct::TaskEntry;
-    parser_t parser;
+    using chronos::system::spawn::requires_shell;
 
-    TaskEntry output;
+    GIVEN ("Commands with and without shell syntax")
+    {
+        THEN ("Only the ones using shell syntax go through the shell")
+        {
+            REQUIRE(!requires_shell("./backup.sh --target=/mnt/disk -v"));
+            REQUIRE(requires_shell("echo $HOME"));
+            REQUIRE(requires_shell("ls | wc -l"));
+            REQUIRE(requires_shell("echo \"quoted text\""));
+            REQUIRE(requires_shell("LANG=C date"));
+            REQUIRE(requires_shell("cd /tmp"));
+        }
+    }
 
-    GIVEN("The entry")
+    GIVEN ("Spawning system call")
     {
-        const std::string entry {
-            "Run \"./program -i --param\" every day at 12:00;"};
+        chronos::SpawnCall execute;
 
-        WHEN ("Entry is parsed")
+        WHEN ("Commands are executed")
         {
-            std::string::const_iterator iter { entry.begin() };
-            std::string::const_iterator end { entry.end() };
-            const bool result {
-                    phrase_parse(iter, end, parser, space, output) };
+            const auto direct { test::keep(execute(
+                    test::command_task("echo direct   call"))) };
+            const auto shell { test::keep(execute(
+                    test::command_task("echo shell >&2; exit 3"))) };
+            const auto missing { test::keep(execute(
+                    test::command_task("./no-such-program"))) };
+
+            THEN ("Output, errors and exit codes are reported")
+            {
+                REQUIRE(direct.success);
+                REQUIRE(direct.message == "direct call\n");
+                REQUIRE(!shell.success);
+                REQUIRE(shell.message == "shell\n");
+                REQUIRE(!missing.success);
+            }
+        }
+    }
+}
 
-            THEN ("Parsing is successful")
+SCENARIO ("Reactor supervises many concurrent children at once", "[unit]")
+{
+    GIVEN ("Reactor based execution")
+    {
+        constexpr int CHILDREN_COUNT { 50 };
+        std::mutex mutex;
+        std::vector<test::system::Response> responses;
+        const auto collect { [&mutex, &responses] (const auto &response) {
+            std::lock_guard<std::mutex> lock(mutex);
+            responses.push_back(test::keep(response)); } };
+        const auto collected_count { [&mutex, &responses] () {
+            std::lock_guard<std::mutex> lock(mutex);
+            return responses.size(); } };
+
+        chronos::ReactorCall execute;
+
+        WHEN ("Slow, chatty and failing commands run together")
+        {
+            const auto start { std::chrono::steady_clock::now() };
+            auto chatty { test::command_task("head -c 1000000 /dev/zero") };
+            chatty.output_limit = 2000000;
+            for (int i = 0; i < CHILDREN_COUNT; ++i)
+                execute(test::command_task("sleep 0.2"), collect);
+            execute(chatty, collect);
+            execute(test::command_task("ls /no/such/directory"), collect);
+
+            THEN ("All complete in about the time of the slowest one")
+            {
+                REQUIRE(test::eventually([&] () {
+                    return collected_count() == CHILDREN_COUNT + 2; }));
+                const auto elapsed {
+                    std::chrono::steady_clock::now() - start };
+                REQUIRE(elapsed < std::chrono::seconds(5));
+
+                std::lock_guard<std::mutex> lock(mutex);
+                const auto successes { std::count_if(
+                        begin(responses), end(responses),
+                        [] (const auto &response) {
+                            return response.success; }) };
+                const auto longest { std::max_element(
+                        begin(responses), end(responses),
+                        [] (const auto &lhs, const auto &rhs) {
+                            return lhs.message.size()
+                                < rhs.message.size(); }) };
+                REQUIRE(successes == CHILDREN_COUNT + 1);
+                REQUIRE(longest->message.size() == 1000000);
+            }
+        }
+
+        WHEN ("A command closes its output long before it exits,"
+              " next to a quick one")
+        {
+            execute(test::command_task(
+                    "exec >/dev/null 2>&1; sleep 1"), collect);
+            execute(test::command_task("echo quick"), collect);
+
+            THEN ("The quick one is not held up and both succeed")
+            {
+                REQUIRE(test::eventually([&] () {
+                    return collected_count() == 2; }));
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(responses.front().message == "quick\n");
+                REQUIRE(responses.front().success);
+                REQUIRE(responses.back().success);
+            }
+        }
+    }
+}
+
+SCENARIO ("Command output is kept within the capture limit", "[unit]")
+{
+    GIVEN ("Output buffer of 10 bytes")
+    {
+        chronos::system::capture::OutputBuffer output(10);
+
+        WHEN ("Much more output than that is appended in pieces")
+        {
+            output.append("01234");
+            output.append("56789abcdefghij");
+            output.append("klm");
+
+            THEN ("Head and tail are kept and the rest is counted")
+            {
+                REQUIRE(output.view() == "01234ijklm");
+                REQUIRE(output.droppedBytes() == 13);
+                REQUIRE(output.droppedAt() == 5);
+            }
+        }
+    }
+
+    GIVEN ("Task capturing a kilobyte of a megabyte of output")
+    {
+        using chronos::parser::conversions::to_bytes;
+        using chronos::parser::enums::OutputSize;
+
+        auto task { test::command_task("seq 200000") };
+        task.output_limit = to_bytes(OutputSize::KILOBYTES, 1);
+        chronos::SpawnCall execute;
+
+        WHEN ("Task is executed")
+        {
+            const auto response { execute(task) };
+            const auto head { response.message.substr(
+                    0, response.dropped_at) };
+            const auto tail { response.message.substr(
+                    response.dropped_at) };
+
+            THEN ("Only the first and last half kilobyte are kept")
+            {
+                REQUIRE(response.success);
+                REQUIRE(response.message.size() == 1024);
+                REQUIRE(response.dropped_bytes + 1024 == 1288895);
+                REQUIRE(head.substr(0, 8) == "1\n2\n3\n4\n");
+                REQUIRE(tail.substr(tail.size() - 14)
+                        == "199999\n200000\n");
+            }
+        }
+    }
+
+    GIVEN ("Entry with capture part")
+    {
+        using converter_t = chronos::parser::Converter<
+            chronos::TaskBuilder<test::Clock> >;
+
+        converter_t converter;
+        const std::string entries {
+            "Run \"backup\" every day at 3:00 capture 2 megabytes;"
+            "Run \"quiet\" every hour;" };
+
+        WHEN ("Entries are parsed and converted")
+        {
+            const auto parsed { chronos::parser::parse_entries(entries) };
+            const auto &with_capture { parsed.at(0) };
+            const auto &without_capture { parsed.at(1) };
+
+            THEN ("Capture limit is set or left at its default")
+            {
+                REQUIRE(parsed.size() == 2);
+                REQUIRE(converter.convert(with_capture).output_limit
+                        == 2 * 1024 * 1024);
+                REQUIRE(converter.convert(without_capture).output_limit
+                        == chronos::task::constants::DEFAULT_OUTPUT_LIMIT);
+            }
+        }
+    }
+}
+
+SCENARIO ("Command running past its timeout is stopped", "[unit]")
+{
+    GIVEN ("Entries with timeout parts")
+    {
+        using converter_t = chronos::parser::Converter<
+            chronos::TaskBuilder<test::Clock> >;
+
+        converter_t converter;
+        const std::string entries {
+            "Run \"backup\" every day retry after 5 minutes 2 times"
+            " timeout 90 minutes capture 1 megabyte;"
+            "Run \"ping\" every minute timeout a second;" };
+
+        WHEN ("Entries are parsed and converted")
+        {
+            const auto parsed { chronos::parser::parse_entries(entries) };
+            const auto &plural { parsed.at(0) };
+            const auto &singular { parsed.at(1) };
+
+            THEN ("Timeouts are set on the tasks")
+            {
+                REQUIRE(parsed.size() == 2);
+                REQUIRE(converter.convert(plural).timeout
+                        == boost::posix_time::minutes(90));
+                REQUIRE(converter.convert(singular).timeout
+                        == boost::posix_time::seconds(1));
+            }
+        }
+    }
+
+    GIVEN ("Command starting a background job and hanging, one second"
+           " timeout")
+    {
+        auto task { test::command_task("sleep 30 & sleep 30") };
+        task.timeout = boost::posix_time::seconds(1);
+
+        WHEN ("It is spawned and waited for")
+        {
+            chronos::SpawnCall execute;
+            const auto start { std::chrono::steady_clock::now() };
+            const auto response { execute(task) };
+            const auto elapsed { std::chrono::steady_clock::now() - start };
+
+            THEN ("Whole process group is terminated and attempt fails")
+            {
+                REQUIRE(elapsed < std::chrono::seconds(3));
+                REQUIRE(response.timed_out);
+                REQUIRE(!response.success);
+            }
+        }
+
+        WHEN ("It is supervised by the reactor")
+        {
+            std::atomic<bool> completed { false };
+            test::system::Response response;
+            chronos::ReactorCall execute;
+            execute(task, [&] (const auto &reactor_response) {
+                response = test::keep(reactor_response);
+                completed = true; });
+
+            THEN ("It is terminated after the timeout and attempt fails")
+            {
+                REQUIRE(test::eventually([&] () { return completed.load(); }));
+                REQUIRE(response.timed_out);
+                REQUIRE(!response.success);
+            }
+        }
+    }
+
+    GIVEN ("Command closing its output and ignoring termination, one"
+           " second timeout")
+    {
+        auto task { test::command_task(
+                "trap '' TERM; exec >/dev/null 2>&1; sleep 30") };
+        task.timeout = boost::posix_time::seconds(1);
+
+        WHEN ("It is spawned and waited for")
+        {
+            chronos::SpawnCall execute;
+            const auto start { std::chrono::steady_clock::now() };
+            const auto response { execute(task) };
+            const auto elapsed { std::chrono::steady_clock::now() - start };
+
+            THEN ("It is killed after the grace period and attempt fails")
+            {
+                REQUIRE(elapsed < std::chrono::seconds(10));
+                REQUIRE(response.timed_out);
+                REQUIRE(!response.success);
+            }
+        }
+    }
+}
+
+SCENARIO ("Splayed tasks keep stable offsets within their window",
+          "[unit]")
+{
+    using namespace boost::gregorian;
+    using namespace boost::posix_time;
+
+    GIVEN ("Hourly tasks before and after a splay statement")
+    {
+        using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
+
+        test::Clock::time = ptime(date(2021, Mar, 1), time_duration(8, 59, 30));
+        parser_t parser;
+        const std::string content {
+            "Run \"aligned\" every hour at 0;\n"
+            "splay 30 minutes;\n"
+            "Run \"first\" every hour at 0;\n"
+            "Run \"second\" every hour at 0;\n"
+            "Run \"opted out\" every hour at 0 splay 0 seconds;\n"
+            "Run \"own window\" every hour at 0 splay 5 minutes;\n" };
+
+        WHEN ("File is parsed twice")
+        {
+            const auto tasks { parser.parse(content) };
+            const auto again { parser.parse(content) };
+            const auto aligned_time { tasks[0].time };
+
+            THEN ("Start times spread over the window deterministically")
+            {
+                REQUIRE(tasks.size() == 5);
+                REQUIRE(tasks[1].time != tasks[2].time);
+                for (std::size_t i = 1; i < tasks.size(); ++i) {
+                    const auto offset { tasks[i].time - aligned_time };
+                    REQUIRE(offset == chronos::splay_offset(tasks[i]));
+                    REQUIRE(offset <= tasks[i].splay);
+                    REQUIRE(tasks[i].time == again[i].time);
+                }
+                REQUIRE(tasks[3].time == aligned_time);
+                REQUIRE(tasks[4].splay == minutes(5));
+            }
+
+            AND_THEN ("Offsets survive rescheduling")
+            {
+                auto task { tasks[1] };
+                const auto offset { task.time - aligned_time };
+                chronos::transit(task);
+                REQUIRE(task.time - aligned_time
+                        == offset + boost::posix_time::hours(1));
+            }
+        }
+
+        WHEN ("File is parsed again a second before a splayed start")
+        {
+            const auto first_offset {
+                chronos::splay_offset(parser.parse(content)[1]) };
+            const ptime nine_o_clock { date(2021, Mar, 1), hours(9) };
+            test::Clock::time = nine_o_clock + first_offset - seconds(1);
+            const auto tasks { parser.parse(content) };
+
+            THEN ("That start is kept and each task takes its nearest one")
+            {
+                REQUIRE(tasks[1].time == nine_o_clock + first_offset);
+                for (const auto &task : tasks) {
+                    const auto aligned {
+                        task.time - chronos::splay_offset(task) };
+                    REQUIRE(aligned.time_of_day().minutes() == 0);
+                    REQUIRE(aligned.time_of_day().seconds() == 0);
+                    REQUIRE(test::Clock::time < task.time);
+                    REQUIRE(task.time - hours(1) <= test::Clock::time);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO ("Tasks of a group are admitted within its limits", "[unit]")
+{
+    GIVEN ("Group definitions and entries referring to them")
+    {
+        using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
+
+        parser_t parser;
+        const std::string content {
+            "Run \"vacuum\" every day at 2:00 group \"db\";\n"
+            "group \"db\" concurrency 4 rate 30 per minute;\n"
+            "group \"mail\" rate 5 per second;\n"
+            "Run \"send\" every minute group \"mail\";\n"
+            "Run \"other\" every minute group \"undefined\";\n" };
+
+        WHEN ("File is parsed")
+        {
+            const auto tasks { parser.parse(content) };
+
+            THEN ("Tasks carry the limits of their groups")
+            {
+                REQUIRE(tasks.size() == 3);
+                REQUIRE(tasks[0].group.name == "db");
+                REQUIRE(tasks[0].group.max_concurrent == 4);
+                REQUIRE(tasks[0].group.starts_per_second == 0.5);
+                REQUIRE(tasks[1].group.max_concurrent == 0);
+                REQUIRE(tasks[1].group.starts_per_second == 5);
+                REQUIRE(tasks[2].group.name == "undefined");
+                REQUIRE(tasks[2].group.max_concurrent == 0);
+            }
+        }
+    }
+
+    GIVEN ("Admission of a group running at most two tasks at once")
+    {
+        chronos::dispatcher::GroupAdmission<chronos::Task> admission;
+        const auto grouped { [] (const std::string &command) {
+            auto task { test::command_task(command) };
+            task.group = { "db", 2, 0 };
+            return task; } };
+
+        WHEN ("Three tasks of the group and an ungrouped one are due")
+        {
+            const auto first { admission.offer(grouped("first")) };
+            const auto second { admission.offer(grouped("second")) };
+            const auto third { admission.offer(grouped("third")) };
+            const auto ungrouped {
+                admission.offer(test::command_task("ungrouped")) };
+
+            THEN ("Third one waits until one of the others finishes")
+            {
+                REQUIRE(first.size() == 1);
+                REQUIRE(second.size() == 1);
+                REQUIRE(third.empty());
+                REQUIRE(ungrouped.size() == 1);
+                REQUIRE(admission.admitWaiting().empty());
+                REQUIRE(!admission.timeToNextStart());
+
+                const auto after_finish { admission.finish(first.front()) };
+                REQUIRE(after_finish.size() == 1);
+                REQUIRE(after_finish.front().command == "third");
+            }
+        }
+    }
+
+    GIVEN ("Admission of a group starting one task per second")
+    {
+        chronos::dispatcher::GroupAdmission<chronos::Task> admission;
+        auto task { test::command_task("throttled") };
+        task.group = { "slow", 0, 1 };
+
+        WHEN ("Two tasks of the group are due at once")
+        {
+            const auto first { admission.offer(task) };
+            const auto second { admission.offer(task) };
+
+            THEN ("Second one waits for the next start token")
+            {
+                REQUIRE(first.size() == 1);
+                REQUIRE(second.empty());
+                const auto wait { admission.timeToNextStart() };
+                REQUIRE(wait);
+                REQUIRE(*wait > std::chrono::milliseconds(900));
+                REQUIRE(*wait <= std::chrono::seconds(1));
+            }
+        }
+    }
+}
+
+SCENARIO ("Critical tasks start first when slots are scarce", "[unit]")
+{
+    using chronos::task::Priority;
+
+    const auto prioritized { [] (const std::string &command,
+                                 Priority priority) {
+        auto task { test::command_task(command) };
+        task.priority = priority;
+        return task; } };
+
+    GIVEN ("Entries with and without priority")
+    {
+        using parser_t = chronos::Parser<chronos::TaskBuilder<test::Clock> >;
+
+        parser_t parser;
+        const std::string content {
+            "Run \"export billing\" every day at 0:05 priority critical"
+            " group \"db\";\n"
+            "Run \"rotate logs\" every hour;\n" };
+
+        WHEN ("File is parsed")
+        {
+            const auto tasks { parser.parse(content) };
+
+            THEN ("Priority is set or left normal")
+            {
+                REQUIRE(tasks[0].priority == Priority::CRITICAL);
+                REQUIRE(tasks[0].group.name == "db");
+                REQUIRE(tasks[1].priority == Priority::NORMAL);
+            }
+        }
+    }
+
+    GIVEN ("Hundreds of housekeeping tasks waiting for a slot")
+    {
+        chronos::dispatcher::FairQueue<chronos::Task> queue;
+        for (int i = 0; i < 300; ++i) {
+            queue.push(prioritized("housekeeping", Priority::LOW));
+            queue.push(prioritized("report", Priority::HIGH));
+        }
+        for (int i = 0; i < 10; ++i)
+            queue.pop();
+
+        WHEN ("Critical task becomes due and slots free up")
+        {
+            queue.push(prioritized("export billing", Priority::CRITICAL));
+            std::vector<std::string> started;
+            for (int i = 0; i < 90; ++i)
+                started.push_back(queue.pop().command);
+
+            THEN ("It starts next and the rest share slots by weight")
+            {
+                REQUIRE(started.front() == "export billing");
+                const auto reports { std::count(
+                        begin(started), end(started), "report") };
+                const auto housekeeping { std::count(
+                        begin(started), end(started), "housekeeping") };
+                REQUIRE(reports == 71);
+                REQUIRE(housekeeping == 18);
+            }
+        }
+    }
+}
+
+SCENARIO ("Schedule file changes are noticed as they happen", "[unit]")
+{
+    GIVEN ("Lock on a schedule file waiting for its change")
+    {
+        using lock_t = chronos::FileLock<chronos::Timer>;
+
+        const auto directory { test::make_temporary_directory() };
+        const auto path { directory / "schedule" };
+        std::ofstream(path) << "Run \"a\" every hour;";
+        lock_t lock(path);
+        std::atomic<bool> changed { false };
+        const auto start { std::chrono::steady_clock::now() };
+        std::thread waiting([&lock, &changed] () {
+            lock.waitUntilChange(boost::posix_time::seconds(60));
+            changed = true; });
+
+        WHEN ("Editor saves the file by renaming a new one over it")
+        {
+            const auto replacement { directory / ".schedule.swp" };
+            std::ofstream(replacement) << "Run \"b\" every hour;";
+            std_filesystem::rename(replacement, path);
+            waiting.join();
+
+            THEN ("Change is reported well before the polling interval")
+            {
+                const auto elapsed {
+                    std::chrono::steady_clock::now() - start };
+                REQUIRE(changed);
+                REQUIRE(elapsed < std::chrono::seconds(2));
+            }
+        }
+
+        WHEN ("File is only touched and the lock is released")
+        {
+            std::ofstream(path, std::ios::app) << "";
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            const bool changed_before_release { changed };
+            lock.release();
+            waiting.join();
+            const auto wait_start { std::chrono::steady_clock::now() };
+            lock.waitUntilChange(boost::posix_time::seconds(60));
+            const auto later_wait {
+                std::chrono::steady_clock::now() - wait_start };
+
+            THEN ("Nothing is reported until the release stops waiting")
+            {
+                REQUIRE(!changed_before_release);
+                REQUIRE(changed);
+            }
+
+            AND_THEN ("A wait after the release does not block")
+            {
+                REQUIRE(later_wait < std::chrono::seconds(1));
+            }
+        }
+
+        std_filesystem::remove_all(directory);
+    }
+}
+
+SCENARIO ("Schedule file is hashed only when its stamp changes", "[unit]")
+{
+    GIVEN ("Guard of a schedule file")
+    {
+        using chronos::filesystem::guard::FileGuard;
+
+        const auto directory { test::make_temporary_directory() };
+        const auto path { directory / "schedule" };
+        std::ofstream(path) << "Run \"a\" every hour;";
+        FileGuard guard(path);
+
+        WHEN ("File is rewritten with the same contents")
+        {
+            std::ofstream(path) << "Run \"a\" every hour;";
+            const bool changed { guard.checkForChange() };
+
+            THEN ("No change is reported")
+            {
+                REQUIRE(!changed);
+                REQUIRE(!guard.takeContents());
+            }
+        }
+
+        WHEN ("File is rewritten with other contents")
+        {
+            std::ofstream(path) << "Run \"b\" every day;";
+            const bool changed { guard.checkForChange() };
+            const auto contents { guard.takeContents() };
+
+            THEN ("Change is reported with the contents it was found in")
+            {
+                REQUIRE(changed);
+                REQUIRE(contents);
+                REQUIRE(contents->contents() == "Run \"b\" every day;");
+                REQUIRE(!guard.checkForChange());
+            }
+        }
+
+        WHEN ("Contents change but the stamp is restored")
+        {
+            const auto stamp { std_filesystem::last_write_time(path) };
+            std::ofstream(path) << "Run \"c\" every hour;";
+            std_filesystem::last_write_time(path, stamp);
+
+            THEN ("File is not read again")
+            {
+                REQUIRE(!guard.checkForChange());
+            }
+        }
+
+        std_filesystem::remove_all(directory);
+    }
+}
+
+SCENARIO ("Schedule directory is parsed one changed fragment at a time",
+          "[unit]")
+{
+    GIVEN ("Directory of schedule fragments")
+    {
+        using parser_t = test::CountingParser<
+            chronos::Parser<chronos::TaskBuilder<test::Clock> > >;
+        using reader_t = chronos::filesystem::reader::TaskReader<parser_t>;
+
+        const auto directory { test::make_temporary_directory() };
+        std::ofstream(directory / "db.chronos")
+            << "group \"db\" concurrency 2;"
+               "Run \"vacuum\" every day group \"db\";";
+        std::ofstream(directory / "reports.chronos")
+            << "Run \"report\" every hour group \"db\";";
+        std::ofstream(directory / "notes.txt") << "Not a schedule";
+        parser_t::parsed = 0;
+        reader_t reader;
+        const auto tasks { reader.read(directory) };
+
+        WHEN ("Directory is read again without changes")
+        {
+            const auto again { reader.read(directory) };
+
+            THEN ("Fragments are merged in order and parsed once")
+            {
+                REQUIRE(again.size() == 2);
+                REQUIRE(again[0].command == "vacuum");
+                REQUIRE(again[1].command == "report");
+                REQUIRE(again[1].group.max_concurrent == 2);
+                REQUIRE(parser_t::parsed == 2);
+            }
+        }
+
+        WHEN ("Directory is read again after the first times passed")
+        {
+            test::Clock::time += boost::gregorian::days(2);
+            const auto later { reader.read(directory) };
+
+            THEN ("Cached tasks are aligned again from the present")
+            {
+                REQUIRE(later.size() == 2);
+                REQUIRE(later[0].time > test::Clock::time);
+                REQUIRE(later[1].time > test::Clock::time);
+                REQUIRE(later[1].time - test::Clock::time
+                        <= boost::posix_time::hours(1));
+                REQUIRE(parser_t::parsed == 2);
+            }
+        }
+
+        WHEN ("One fragment is saved with other contents")
+        {
+            std::ofstream(directory / "reports.chronos")
+                << "Run \"report\" every hour;"
+                   "Run \"summary\" every day;";
+            const auto changed { reader.read(directory) };
+
+            THEN ("Only that fragment is parsed again")
+            {
+                REQUIRE(changed.size() == 3);
+                REQUIRE(changed[2].command == "summary");
+                REQUIRE(parser_t::parsed == 3);
+            }
+        }
+
+        std_filesystem::remove_all(directory);
+    }
+}
+
+SCENARIO ("Entry with retry parameters is parsed correctly", "[unit]")
+{
+    using chronos::parser::parse_entries;
+
+    GIVEN ("Entry with retry time and count")
+    {
+        const std::string entry {
+            "Run \"test:test\" every 3 hours retry after 5 seconds "
+            "3 times;" };
+
+        WHEN ("Entry is parsed")
+        {
+            const auto entries { parse_entries(entry) };
+
+            THEN ("Parsing is successful")
+            {
+                REQUIRE(entries.size() == 1);
+                REQUIRE(entries[0].command == "test:test");
+                REQUIRE(entries[0].retry_part.retry_time_count == 5);
+                REQUIRE(entries[0].retry_part.retries_count == 3);
+            }
+        }
+    }
+}
+
+SCENARIO ("Entry with specified time is parsed correctly", "[unit]")
+{
+    using chronos::parser::parse_entries;
+
+    GIVEN ("Entry with 'at' part")
+    {
+        const std::string entry {
+                "Run \"./program -i --param\" every month at 2 12:30"
+                " retry after 5 seconds 3 times;" };
+
+        WHEN ("Entry is parsed")
+        {
+            const auto entries { parse_entries(entry) };
+
+            THEN ("Parsing is successful")
+            {
+                REQUIRE(entries.size() == 1);
+                REQUIRE(std::get<int>(entries[0].at_part.day) == 2);
+                REQUIRE(entries[0].at_part.hour == 12);
+                REQUIRE(entries[0].at_part.minute == 30);
+            }
+        }
+    }
+}
+
+SCENARIO ("Entry with specified hour and singular retry time unit"
+         " is parsed correctly", "[unit]")
+{
+    using chronos::parser::parse_entries;
+
+    GIVEN("Entry with 'at' part")
+    {
+        const std::string entry {
+                "Run \"./program -i --param\" every day at 23:15"
+                " retry after a minute;" };
+
+        WHEN ("Entry is parsed")
+        {
+            const auto entries { parse_entries(entry) };
+
+            THEN ("Parsing is successful")
+            {
+                REQUIRE(entries.size() == 1);
+                REQUIRE(entries[0].at_part.hour == 23);
+                REQUIRE(entries[0].at_part.minute == 15);
+                REQUIRE(entries[0].retry_part.retry_time_count == 1);
+                REQUIRE(entries[0].retry_part.retries_count == 1);
+            }
+        }
+    }
+}
+
+SCENARIO ("Entry is parsed correctly when minute part is 00", "[unit]")
+{
+    using chronos::parser::parse_entries;
+
+    GIVEN("The entry")
+    {
+        const std::string entry {
+            "Run \"./program -i --param\" every day at 12:00;"};
+
+        WHEN ("Entry is parsed")
+        {
+            const auto entries { parse_entries(entry) };
+
+            THEN ("Parsing is successful")
+            {
+                REQUIRE(entries.size() == 1);
+                REQUIRE(entries[0].at_part.hour == 12);
+                REQUIRE(entries[0].at_part.minute == 0);
+            }
+        }
+    }
+}
+
+SCENARIO ("Malformed schedule is reported at the offending token",
+          "[unit]")
+{
+    using chronos::parser::parse_entries;
+    using chronos::parser::error::SyntaxError;
+
+    GIVEN ("Entries spelled in mixed case and with every form of 'at'")
+    {
+        const std::string content {
+            "RUN \"a\" Every Week At Friday 17.30 Priority HIGH;\n"
+            "run \"b\" every 2 hours at 45 retry after an hour;\n"
+            "run \"c\" every month at 31 0:05;\n" };
+
+        WHEN ("Content is parsed")
+        {
+            const auto entries { parse_entries(content) };
+
+            THEN ("Parts are recognized regardless of case")
+            {
+                using chronos::parser::enums::TaskPriority;
+                using chronos::parser::enums::WeekDay;
+                REQUIRE(entries.size() == 3);
+                REQUIRE(std::get<WeekDay>(entries[0].at_part.day)
+                        == WeekDay::FRIDAY);
+                REQUIRE(entries[0].at_part.minute == 30);
+                REQUIRE(entries[0].priority == TaskPriority::HIGH);
+                REQUIRE(entries[1].at_part.minute == 45);
+                REQUIRE(std::get<int>(entries[2].at_part.day) == 31);
+            }
+        }
+    }
+
+    GIVEN ("Schedules with a mistake on their third line")
+    {
+        const std::string prefix {
+            "Run \"a\" every hour;\n"
+            "splay 5 minutes;\n" };
+
+        THEN ("Line and column of the mistake are reported")
+        {
+            const auto error_position { [&prefix] (const std::string &line) {
+                try {
+                    parse_entries(prefix + line);
+                } catch (const SyntaxError &error) {
+                    return std::make_pair(error.line(), error.column());
+                }
+                return std::make_pair(std::size_t(0), std::size_t(0)); } };
+
+            REQUIRE(error_position("Run \"b\" every 3 hour;")
+                    == std::make_pair(std::size_t(3), std::size_t(17)));
+            REQUIRE(error_position("  Run \"b\" every day at 25:00;")
+                    == std::make_pair(std::size_t(3), std::size_t(24)));
+            REQUIRE(error_position("Run \"b\" every week;")
+                    == std::make_pair(std::size_t(3), std::size_t(19)));
+            REQUIRE(error_position("Run \"b\" every hour")
+                    == std::make_pair(std::size_t(3), std::size_t(19)));
+            REQUIRE(error_position("Rnu \"b\" every hour;")
+                    == std::make_pair(std::size_t(3), std::size_t(1)));
+        }
+    }
+}
+
+SCENARIO ("Schedule parsed in chunks matches a single pass", "[unit]")
+{
+    using chronos::parser::parse_entries;
+    using chronos::parser::error::SyntaxError;
+
+    GIVEN ("Entries with terminators in quotes, splays and groups")
+    {
+        std::string content { "run \"x;y\" every minute group \"g\";\n" };
+        for (int i = 0; i < 40; ++i) {
+            content += fmt::format(
+                    "run \"echo {0}; true\" every {1} minutes{2};\n",
+                    i, i % 5 + 2, i % 3 == 0 ? " group \"g\"" : "");
+            if (i % 7 == 6)
+                content += fmt::format("splay {} seconds;\n", i);
+        }
+        content += "group \"g\" concurrency 2;\n";
+
+        WHEN ("Content is parsed in several chunks and in one")
+        {
+            const auto chunked { parse_entries(content, 6) };
+            const auto whole { parse_entries(content, 1) };
+
+            THEN ("Entries are the same and in the same order")
+            {
+                REQUIRE(whole.size() == 41);
+                REQUIRE(chunked.size() == whole.size());
+                for (std::size_t i = 0; i < whole.size(); ++i) {
+                    REQUIRE(chunked[i].command == whole[i].command);
+                    REQUIRE(chunked[i].splay_part.splay_time_count
+                            == whole[i].splay_part.splay_time_count);
+                    REQUIRE(chunked[i].group_definition.max_concurrent
+                            == whole[i].group_definition.max_concurrent);
+                }
+                REQUIRE(whole[0].command == "x;y");
+                REQUIRE(whole[0].group_definition.max_concurrent == 2);
+                REQUIRE(whole[40].splay_part.splay_time_count == 34);
+            }
+        }
+
+        WHEN ("A mistake follows many lines")
+        {
+            content += "run \"z\" every 3 hour;\n";
+
+            THEN ("Its position is the one of a single pass")
+            {
+                std::size_t line { 0 }, column { 0 };
+                try {
+                    parse_entries(content, 6);
+                } catch (const SyntaxError &error) {
+                    line = error.line();
+                    column = error.column();
+                }
+                REQUIRE(line == 48);
+                REQUIRE(column == 17);
+            }
+        }
+    }
+}
+
+SCENARIO ("Compiled schedule loads the tasks its source parses to",
+          "[unit]")
+{
+    using task_builder_t = chronos::TaskBuilder<test::Clock>;
+    using parser_t = chronos::Parser<task_builder_t>;
+
+    GIVEN ("A schedule with every kind of alignment and a compiled image")
+    {
+        const std::string source {
+            "group \"g\" concurrency 2;\n"
+            "run \"a\" every 5 minutes splay 30 seconds;\n"
+            "run \"b\" every 2 hours at 45 retry after 2 minutes 3 times;\n"
+            "run \"c\" every day at 3:15 priority high group \"g\";\n"
+            "run \"d\" every week at friday 17:30 timeout 10 minutes;\n"
+            "run \"e\" every month at 31 0:05 capture 4 kilobytes;\n" };
+        const auto image { chronos::cache::compile<task_builder_t>(source) };
+
+        WHEN ("The image is loaded for the same source")
+        {
+            const auto loaded {
+                chronos::cache::load<test::Clock>(image, source) };
+            const auto parsed { parser_t().parse(source) };
+
+            THEN ("Tasks are the parsed ones")
+            {
+                REQUIRE(loaded);
+                REQUIRE(loaded->size() == parsed.size());
+                for (std::size_t i = 0; i < parsed.size(); ++i) {
+                    const auto &task { (*loaded)[i] };
+                    REQUIRE(task.command == parsed[i].command);
+                    REQUIRE(task.time == parsed[i].time);
+                    REQUIRE(task.interval == parsed[i].interval);
+                    REQUIRE(task.group.name == parsed[i].group.name);
+                    REQUIRE(task.group.max_concurrent
+                            == parsed[i].group.max_concurrent);
+                    REQUIRE(chronos::same_definition(
+                            chronos::to_record(task),
+                            chronos::to_record(parsed[i])));
+                }
+            }
+        }
+
+        WHEN ("The source changes or the image is damaged")
+        {
+            THEN ("Image is not used")
+            {
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        image, source + "run \"f\" every hour;"));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        image.substr(0, image.size() - 1), source));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        std::string(image.size(), '\0'), source));
+            }
+        }
+
+        WHEN ("The source is compiled again")
+        {
+            const auto again {
+                chronos::cache::compile<task_builder_t>(source) };
+
+            THEN ("Image is the same byte for byte")
+            {
+                REQUIRE(again == image);
+            }
+        }
+
+        WHEN ("A task of the image holds a value out of its range")
+        {
+            using chronos::cache::format::Alignment;
+            using chronos::cache::format::CompiledTask;
+            const auto damaged { [&image] (auto damage) {
+                constexpr auto OFFSET {
+                    sizeof(chronos::cache::format::Header) };
+                auto copy { image };
+                CompiledTask task;
+                std::memcpy(&task, copy.data() + OFFSET, sizeof(task));
+                damage(task);
+                std::memcpy(copy.data() + OFFSET, &task, sizeof(task));
+                return copy; } };
+
+            THEN ("Image is not used although its source matches")
+            {
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &task) {
+                            task.record.priority =
+                                chronos::task::Priority(4); }), source));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &task) {
+                            task.record.interval_unit = 4; }), source));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &task) {
+                            task.alignment = Alignment(6); }), source));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &task) {
+                            task.record.cron.months = 1 << 13; }), source));
+                REQUIRE_FALSE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &task) {
+                            task.record.interval_count = 0; }), source));
+                REQUIRE(chronos::cache::load<test::Clock>(
+                        damaged([] (CompiledTask &) { }), source));
+            }
+        }
+    }
+}
+
+SCENARIO ("Cron entries fire at the minutes their expressions allow",
+          "[unit]")
+{
+    using chronos::parser::parse_entries;
+    using chronos::parser::error::SyntaxError;
+    using ptime_t = boost::posix_time::ptime;
+    using date_t = boost::gregorian::date;
+    using boost::posix_time::hours;
+    using boost::posix_time::minutes;
+
+    GIVEN ("Crontab lines as cron entries")
+    {
+        const std::string content {
+            "run \"a\" cron \"*/5 9-17 * * 1-5\" retry after 2 minutes;\n"
+            "run \"b\" cron \"0 0 13 * fri\";\n"
+            "run \"c\" cron \"30 2 29 feb *\";\n"
+            "run \"d\" cron \"15,45 */6 1-7 jan-mar,dec 0\";\n" };
+        const auto entries { parse_entries(content) };
+        // Friday, 7 August 2020
+        const ptime_t friday { date_t(2020, 8, 7), hours(17) + minutes(57) };
+
+        THEN ("Fields are compiled into their bits")
+        {
+            const auto &weekdays { entries[0].cron };
+            REQUIRE(weekdays.minutes == 0x084210842108421ull);
+            REQUIRE(weekdays.hours == 0x3fe00);
+            REQUIRE(weekdays.week_days == 0x3e);
+            REQUIRE_FALSE(weekdays.either_day);
+            REQUIRE(entries[0].retry_part.retries_count == 1);
+            REQUIRE(entries[1].cron.either_day);
+            REQUIRE(entries[3].cron.months == ((1 << 1) | (1 << 2)
+                                               | (1 << 3) | (1 << 12)));
+        }
+
+        THEN ("Next fire time skips to the next allowed values")
+        {
+            using chronos::cron::next_fire;
+            REQUIRE(next_fire(entries[0].cron, friday)
+                    == ptime_t(date_t(2020, 8, 10), hours(9)));
+            REQUIRE(next_fire(entries[0].cron, friday - hours(1))
+                    == ptime_t(date_t(2020, 8, 7), hours(17)));
+            REQUIRE(next_fire(entries[1].cron, friday)
+                    == ptime_t(date_t(2020, 8, 13), hours(0)));
+            REQUIRE(next_fire(entries[2].cron, friday)
+                    == ptime_t(date_t(2024, 2, 29),
+                               hours(2) + minutes(30)));
+            REQUIRE(next_fire(entries[3].cron, friday)
+                    == ptime_t(date_t(2020, 12, 1),
+                               hours(0) + minutes(15)));
+        }
+
+        THEN ("A transited cron task follows its expression")
+        {
+            using task_builder_t = chronos::TaskBuilder<test::Clock>;
+            chronos::parser::Converter<task_builder_t> converter;
+            auto task { converter.convert(entries[0]) };
+            task.time = ptime_t(date_t(2020, 8, 7), hours(17) + minutes(55));
+            chronos::transit(task);
+            REQUIRE(task.time == ptime_t(date_t(2020, 8, 10), hours(9)));
+            chronos::transit(task);
+            REQUIRE(task.time == ptime_t(date_t(2020, 8, 10),
+                                         hours(9) + minutes(5)));
+        }
+    }
+
+    GIVEN ("Cron entries with mistakes")
+    {
+        const auto error_column { [] (const std::string &entry) {
+            try {
+                parse_entries(entry);
+            } catch (const SyntaxError &error) {
+                return error.column();
+            }
+            return std::size_t(0); } };
+
+        THEN ("The offending field is reported")
+        {
+            REQUIRE(error_column("run \"a\" cron \"61 * * * *\";") == 15);
+            REQUIRE(error_column("run \"a\" cron \"* * * * 1-\";") == 25);
+            REQUIRE(error_column("run \"a\" cron \"* * 5-2 * *\";") == 19);
+            REQUIRE(error_column("run \"a\" cron \"* * * *\";") == 22);
+            REQUIRE(error_column("run \"a\" cron \"* * 30 feb *\";") == 14);
+            REQUIRE(error_column("run \"a\" every;") == 14);
+        }
+    }
+}
+
+SCENARIO ("Integer epoch times follow Boost calendar arithmetic", "[unit]")
+{
+    namespace epoch = chronos::time::epoch;
+    using ptime_t = boost::posix_time::ptime;
+    using date_t = boost::gregorian::date;
+    using boost::posix_time::hours;
+    using boost::posix_time::minutes;
+
+    GIVEN ("Times around month ends, leap days and before the epoch")
+    {
+        const std::vector<ptime_t> times {
+            ptime_t(date_t(1960, 1, 1)),
+            ptime_t(date_t(1969, 12, 31), hours(23) + minutes(59)),
+            ptime_t(date_t(2020, 1, 31), hours(3) + minutes(15)),
+            ptime_t(date_t(2020, 2, 29), hours(12)),
+            ptime_t(date_t(2021, 1, 30), minutes(1)),
+            ptime_t(date_t(2100, 2, 28), hours(6)) };
+
+        THEN ("Conversion round trips")
+        {
+            for (const auto &time : times)
+                REQUIRE(epoch::from_epoch(epoch::to_epoch(time)) == time);
+            const ptime_t infinity(boost::posix_time::pos_infin);
+            REQUIRE(epoch::from_epoch(epoch::to_epoch(infinity))
+                    == infinity);
+            REQUIRE(epoch::from_epoch(epoch::to_epoch(ptime_t()))
+                    .is_not_a_date_time());
+        }
+
+        THEN ("Adding intervals gives the times Boost gives")
+        {
+            for (const auto &time : times)
+                for (const int count : { 1, 2, 11, 13, 25 }) {
+                    const auto start { epoch::to_epoch(time) };
+                    const boost::gregorian::months months(count);
+                    REQUIRE(epoch::from_epoch(
+                            epoch::transit(start, months))
+                            == ptime_t(time.date() + months,
+                                       time.time_of_day()));
+                    const boost::gregorian::weeks weeks(count);
+                    REQUIRE(epoch::from_epoch(
+                            epoch::transit(start, weeks))
+                            == time + weeks);
+                    REQUIRE(epoch::from_epoch(
+                            epoch::transit(start, hours(count)))
+                            == time + hours(count));
+                }
+        }
+    }
+}
+
+SCENARIO ("Timer waits sub-second durations to their deadline", "[unit]")
+{
+    using boost::posix_time::milliseconds;
+    using steady_clock_t = std::chrono::steady_clock;
+    using milliseconds_t = std::chrono::milliseconds;
+
+    GIVEN ("A timer")
+    {
+        chronos::Timer timer;
+
+        WHEN ("It waits for a fraction of a second")
+        {
+            const auto start { steady_clock_t::now() };
+            timer.wait(milliseconds(30));
+            const auto waited { steady_clock_t::now() - start };
+
+            THEN ("The wait is neither rounded down nor to a second")
+            {
+                REQUIRE(waited >= milliseconds_t(30));
+                REQUIRE(waited < milliseconds_t(500));
+            }
+        }
+
+        WHEN ("It waits for a time already past")
+        {
+            const auto start { steady_clock_t::now() };
+            timer.wait(milliseconds(-30));
+
+            THEN ("It returns at once")
             {
-                const bool success { result && iter == end };
-                REQUIRE(success);
+                REQUIRE(steady_clock_t::now() - start < milliseconds_t(20));
             }
         }
     }
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "fmt/core.h"
+#include "chronos/Schedule.hpp"
+#include "chronos/Task.hpp"
+#include "chronos/Timer.hpp"
+
+
+namespace benchmark
+{
+    using namespace boost::posix_time;
+
+    constexpr int TASKS_COUNT { 20 };
+    constexpr int SPACING_MILLISECONDS { 137 };
+
+    /*
+     * Runs tasks spread off whole seconds the way the coordinator does:
+     * waiting for the time to the next task, then taking the due ones.
+     * Lateness is measured against a microsecond clock in both cases.
+     */
+    template <typename ClockT>
+    void measure(const std::string &name)
+    {
+        chronos::Schedule<chronos::Task, ClockT> schedule;
+        const auto start { microsec_clock::local_time() };
+        for (int i = 1; i <= TASKS_COUNT; ++i) {
+            chronos::Task task;
+            task.command = fmt::format("task {}", i);
+            task.time = start + milliseconds(i * SPACING_MILLISECONDS);
+            task.interval = hours(1);
+            schedule.add(task);
+        }
+
+        chronos::Timer timer;
+        std::vector<double> lateness;
+        int waits_count { 0 };
+        while (lateness.size() < TASKS_COUNT) {
+            timer.wait(schedule.timeToNextTask());
+            ++waits_count;
+            for (const auto &task : schedule.withdrawDueTasks()) {
+                const auto late { microsec_clock::local_time() - task.time };
+                lateness.push_back(late.total_microseconds() / 1e3);
+            }
+        }
+
+        std::sort(begin(lateness), end(lateness));
+        double total { 0 };
+        for (const auto value : lateness)
+            total += value;
+        fmt::print("{:<28} mean {:>7.2f} ms  median {:>7.2f} ms"
+                   "  max {:>7.2f} ms  waits {}\n",
+                   name, total / lateness.size(),
+                   lateness[lateness.size() / 2], lateness.back(),
+                   waits_count);
+    }
+}
+
+int main()
+{
+    using namespace benchmark;
+    fmt::print("Start lateness of {} tasks {} ms apart\n",
+               TASKS_COUNT, SPACING_MILLISECONDS);
+    measure<second_clock>("Schedule on second_clock");
+    measure<microsec_clock>("Schedule on microsec_clock");
+    return 0;
+}